@@ -0,0 +1,259 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Bucket sieve used to apply large sieving primes.
+*
+* This file implements the bucket sieve used to apply sieving primes that land at most one mark per segment.
+***********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "compiler.h"
+#include "gf2.h"
+#include "prime_list.h"
+#include "sieving_primes.h"
+#include "bucket_sieve.h"
+
+
+#define BUCKET_CHUNK_ENTRIES (1024)
+
+
+typedef struct BucketEntry {
+    Gf2Polynomial multiple;
+    uint32_t      prime;
+} BucketEntry;
+
+
+typedef struct BucketChunk {
+    struct BucketChunk* next;
+    unsigned            numberEntries;
+    BucketEntry         entries[BUCKET_CHUNK_ENTRIES];
+} BucketChunk;
+
+
+struct BucketSieve {
+    BucketChunk**  buckets;
+    BucketChunk*   freeChunks;
+    unsigned long  bucketMask;
+    unsigned       segmentSizeLog2;
+    Gf2Polynomial  lastValue;
+};
+
+
+static Gf2Polynomial firstOddMultiple(Gf2Polynomial const prime, Gf2Polynomial const value) {
+    unsigned      degree     = gf2Degree(prime);
+    Gf2Polynomial blockIndex = value >> degree;
+
+    /* Exactly one multiple of the prime lies in each aligned block of 2^degree values. */
+
+    do {
+        Gf2Polynomial blockStart = blockIndex << degree;
+        Gf2Polynomial multiple   = blockStart ^ gf2Remainder(blockStart, prime);
+
+        if (multiple >= value && (multiple & 1) != 0 && multiple != prime) {
+            return multiple;
+        }
+
+        ++blockIndex;
+    } while ((blockIndex >> (63 - degree)) == 0);
+
+    return 0;
+}
+
+
+static Gf2Polynomial nextOddMultiple(Gf2Polynomial const prime, Gf2Polynomial const multiple) {
+    unsigned      degree     = gf2Degree(prime);
+    Gf2Polynomial highBit    = (Gf2Polynomial) 1 << degree;
+    Gf2Polynomial blockIndex = multiple >> degree;
+    Gf2Polynomial remainder  = multiple & (highBit - 1);
+
+    /* The multiple in block H is H*x^d + (H*x^d mod p).  Stepping H to H+1 flips the low t+1 bits of H, where t is
+     * the number of trailing ones in H, so by linearity the remainder changes by the sum of x^(d+j) mod p for j <= t.
+     * Each of those terms is the previous one times x, reduced by p. */
+
+    do {
+        unsigned      trailingOnes = countTrailingZeros64(~blockIndex);
+        Gf2Polynomial term         = prime ^ highBit;
+        unsigned      j;
+
+        remainder ^= term;
+        for (j=0 ; j<trailingOnes ; ++j) {
+            term <<= 1;
+            if (term & highBit) {
+                term ^= prime;
+            }
+
+            remainder ^= term;
+        }
+
+        ++blockIndex;
+    } while ((remainder & 1) == 0 && (blockIndex >> (63 - degree)) == 0);
+
+    if ((blockIndex >> (63 - degree)) != 0) {
+        return 0;
+    }
+
+    return (blockIndex << degree) | remainder;
+}
+
+
+static void pushEntry(BucketSieve* const bucketSieve, Gf2Polynomial const multiple, uint32_t const prime) {
+    unsigned long bucketIndex = (multiple >> bucketSieve->segmentSizeLog2) & bucketSieve->bucketMask;
+    BucketChunk*  chunk       = bucketSieve->buckets[bucketIndex];
+
+    if (chunk == NULL || chunk->numberEntries == BUCKET_CHUNK_ENTRIES) {
+        BucketChunk* newChunk = bucketSieve->freeChunks;
+
+        if (newChunk != NULL) {
+            bucketSieve->freeChunks = newChunk->next;
+        } else {
+            newChunk = malloc(sizeof(BucketChunk));
+            assert(newChunk != NULL);
+        }
+
+        newChunk->next          = chunk;
+        newChunk->numberEntries = 0;
+
+        bucketSieve->buckets[bucketIndex] = newChunk;
+        chunk = newChunk;
+    }
+
+    chunk->entries[chunk->numberEntries].multiple = multiple;
+    chunk->entries[chunk->numberEntries].prime    = prime;
+    ++chunk->numberEntries;
+}
+
+
+static void releaseChunks(BucketChunk* chunk) {
+    while (chunk != NULL) {
+        BucketChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+
+unsigned long firstBucketSievingPrime(SievingPrimes const* const sievingPrimes, unsigned const segmentSizeLog2) {
+    return firstSievingPrimeOfDegree(sievingPrimes, segmentSizeLog2);
+}
+
+
+BucketSieve* createBucketSieve(
+        SievingPrimes const* const sievingPrimes,
+        unsigned long const        firstPrime,
+        unsigned const             segmentSizeLog2,
+        Gf2Polynomial const        firstValue,
+        Gf2Polynomial const        lastValue
+    ) {
+    BucketSieve*  bucketSieve = malloc(sizeof(BucketSieve));
+    unsigned long numberBuckets;
+    unsigned long i;
+
+    assert(bucketSieve != NULL);
+
+    /* A prime's next multiple is less than 2^(degree+1) values past its current multiple so the buckets only need to
+     * reach that far ahead of the segment being drained. */
+
+    numberBuckets = 2;
+    if (sievingPrimes->maximumDegree + 1 > segmentSizeLog2) {
+        numberBuckets = (1UL << (sievingPrimes->maximumDegree + 1 - segmentSizeLog2)) + 2;
+    }
+
+    while ((numberBuckets & (numberBuckets - 1)) != 0) {
+        numberBuckets += numberBuckets & -numberBuckets;
+    }
+
+    bucketSieve->buckets = calloc(numberBuckets, sizeof(BucketChunk*));
+    assert(bucketSieve->buckets != NULL);
+
+    bucketSieve->freeChunks      = NULL;
+    bucketSieve->bucketMask      = numberBuckets - 1;
+    bucketSieve->segmentSizeLog2 = segmentSizeLog2;
+    bucketSieve->lastValue       = lastValue;
+
+    for (i=firstPrime ; i<sievingPrimes->numberPrimes ; ++i) {
+        uint32_t      prime    = sievingPrimes->primes[i];
+        Gf2Polynomial multiple = firstOddMultiple(prime, firstValue);
+
+        assert(gf2Degree(prime) >= segmentSizeLog2);
+
+        if (multiple != 0 && multiple <= lastValue) {
+            pushEntry(bucketSieve, multiple, prime);
+        }
+    }
+
+    return bucketSieve;
+}
+
+
+void applyBucketSieve(BucketSieve* const bucketSieve, PoolBuffer* const poolBuffer) {
+    Gf2Polynomial firstValue;
+    Gf2Polynomial lastValue;
+    Gf2Polynomial segment;
+    Gf2Polynomial lastSegment;
+
+    poolBufferBounds(poolBuffer, &firstValue, &lastValue);
+
+    lastSegment = lastValue >> bucketSieve->segmentSizeLog2;
+    for (segment=firstValue >> bucketSieve->segmentSizeLog2 ; segment <= lastSegment ; ++segment) {
+        unsigned long bucketIndex = segment & bucketSieve->bucketMask;
+        BucketChunk*  chunk       = bucketSieve->buckets[bucketIndex];
+
+        bucketSieve->buckets[bucketIndex] = NULL;
+
+        while (chunk != NULL) {
+            BucketChunk* next = chunk->next;
+            unsigned     i;
+
+            for (i=0 ; i<chunk->numberEntries ; ++i) {
+                BucketEntry const* entry = chunk->entries + i;
+
+                if (entry->multiple > lastValue) {
+                    pushEntry(bucketSieve, entry->multiple, entry->prime);
+                } else {
+                    Gf2Polynomial multiple;
+
+                    markCompositeInPoolBuffer(poolBuffer, entry->multiple);
+
+                    multiple = nextOddMultiple(entry->prime, entry->multiple);
+                    if (multiple != 0 && multiple <= bucketSieve->lastValue) {
+                        pushEntry(bucketSieve, multiple, entry->prime);
+                    }
+                }
+            }
+
+            chunk->next = bucketSieve->freeChunks;
+            bucketSieve->freeChunks = chunk;
+
+            chunk = next;
+        }
+    }
+}
+
+
+void destroyBucketSieve(BucketSieve* const bucketSieve) {
+    unsigned long i;
+
+    for (i=0 ; i<=bucketSieve->bucketMask ; ++i) {
+        releaseChunks(bucketSieve->buckets[i]);
+    }
+
+    releaseChunks(bucketSieve->freeChunks);
+
+    free(bucketSieve->buckets);
+    free(bucketSieve);
+}
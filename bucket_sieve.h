@@ -0,0 +1,100 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Bucket sieve used to apply large sieving primes.
+*
+* This file defines functions used to apply sieving primes that land at most one mark per segment.  A prime of degree
+* d has exactly one multiple in every aligned block of 2^d values, so its multiples can be generated in increasing
+* order.  Each prime's next odd multiple is held in the bucket for the segment containing it.  When a pool is sieved,
+* each of its segments' buckets is drained in a single pass and every prime is moved to the bucket holding its
+* following multiple.
+***********************************************************************************************************************/
+
+#ifndef BUCKET_SIEVE_H
+#define BUCKET_SIEVE_H
+
+#include "gf2.h"
+#include "prime_list.h"
+#include "sieving_primes.h"
+
+/*******************************************************************************************************************//**
+* \brief Opaque bucket sieve state.
+*
+* You can use this type to track the pending multiples of the large sieving primes across a contiguous range of pools.
+* Each thread should use its own bucket sieve.
+***********************************************************************************************************************/
+typedef struct BucketSieve BucketSieve;
+
+/*******************************************************************************************************************//**
+* \brief Determines which sieving primes should be handled by the bucket sieve.
+*
+* You can use this function to locate the first sieving prime whose degree is at least segmentSizeLog2.  That prime
+* and every later prime in the table land at most one mark per segment.
+*
+* \param[in] sievingPrimes   The table of sieving primes.
+*
+* \param[in] segmentSizeLog2 The base 2 log of the number of values spanned by a segment.
+*
+* \return Returns the index of the first sieving prime to be handled by the bucket sieve.
+***********************************************************************************************************************/
+unsigned long firstBucketSievingPrime(SievingPrimes const* const sievingPrimes, unsigned const segmentSizeLog2);
+
+/*******************************************************************************************************************//**
+* \brief Creates a bucket sieve.
+*
+* You can use this function to create a bucket sieve covering a contiguous range of values.  The first multiple of
+* every large sieving prime inside the range is placed into its bucket.
+*
+* \param[in] sievingPrimes   The table of sieving primes.
+*
+* \param[in] firstPrime      The index of the first sieving prime to be handled by the bucket sieve.
+*
+* \param[in] segmentSizeLog2 The base 2 log of the number of values spanned by a segment.
+*
+* \param[in] firstValue      The first value covered by the bucket sieve.
+*
+* \param[in] lastValue       The last value covered by the bucket sieve.
+*
+* \return Returns a pointer to the new bucket sieve.
+***********************************************************************************************************************/
+BucketSieve* createBucketSieve(
+    SievingPrimes const* const sievingPrimes,
+    unsigned long const        firstPrime,
+    unsigned const             segmentSizeLog2,
+    Gf2Polynomial const        firstValue,
+    Gf2Polynomial const        lastValue
+);
+
+/*******************************************************************************************************************//**
+* \brief Applies the bucket sieve to a pool.
+*
+* You can use this function to mark every pending multiple that falls inside the pool held by a pool buffer.  Pools
+* must be presented in increasing order.
+*
+* \param[in,out] bucketSieve The bucket sieve to drain.
+*
+* \param[in,out] poolBuffer  The pool buffer holding the pool to be marked.
+***********************************************************************************************************************/
+void applyBucketSieve(BucketSieve* const bucketSieve, PoolBuffer* const poolBuffer);
+
+/*******************************************************************************************************************//**
+* \brief Releases a bucket sieve.
+*
+* You can use this function to release all memory held by a bucket sieve.
+*
+* \param[in] bucketSieve The bucket sieve to release.
+***********************************************************************************************************************/
+void destroyBucketSieve(BucketSieve* const bucketSieve);
+
+#endif
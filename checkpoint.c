@@ -0,0 +1,186 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Checkpoints used to resume an interrupted sieve.
+*
+* This file implements functions used to record and recover the progress of a sieve.
+***********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "gf2.h"
+#include "checkpoint.h"
+
+
+/* Version 3 checkpoints describe a single container file whose pools mark composites with set bits.  Checkpoints from
+ * earlier versions describe separate pool files that can not be resumed. */
+
+#define CHECKPOINT_VERSION (3)
+
+
+void initializeCheckpoint(Checkpoint* const checkpoint, unsigned long const numberRanges) {
+    checkpoint->maximumPrime     = 0;
+    checkpoint->poolSizeInBytes  = 0;
+    checkpoint->puddleSize       = 0;
+    checkpoint->segmented        = 0;
+    checkpoint->nextSievingPrime = 0;
+    checkpoint->numberRanges     = numberRanges;
+    checkpoint->ranges           = NULL;
+
+    if (numberRanges > 0) {
+        checkpoint->ranges = malloc(numberRanges * sizeof(CheckpointRange));
+        assert(checkpoint->ranges != NULL);
+    }
+}
+
+
+int readCheckpoint(Checkpoint* const checkpoint, char const* const filename) {
+    FILE*         file = fopen(filename, "r");
+    Checkpoint    header;
+    unsigned      version;
+    unsigned long numberRanges;
+    unsigned long i;
+    int           success;
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    success = (
+           fscanf(file, " sieve_of_eratosthenes_gf2 checkpoint %u", &version) == 1
+        && version == CHECKPOINT_VERSION
+        && fscanf(file, " maximum_prime %" SCNx64, &header.maximumPrime) == 1
+        && fscanf(file, " pool_size_in_bytes %lu", &header.poolSizeInBytes) == 1
+        && fscanf(file, " puddle_size %u", &header.puddleSize) == 1
+        && fscanf(file, " segmented %d", &header.segmented) == 1
+        && fscanf(file, " next_sieving_prime %lu", &header.nextSievingPrime) == 1
+        && fscanf(file, " ranges %lu", &numberRanges) == 1
+    );
+
+    if (success) {
+        initializeCheckpoint(checkpoint, numberRanges);
+
+        checkpoint->maximumPrime     = header.maximumPrime;
+        checkpoint->poolSizeInBytes  = header.poolSizeInBytes;
+        checkpoint->puddleSize       = header.puddleSize;
+        checkpoint->segmented        = header.segmented;
+        checkpoint->nextSievingPrime = header.nextSievingPrime;
+
+        for (i=0 ; success && i<numberRanges ; ++i) {
+            CheckpointRange* range = checkpoint->ranges + i;
+            success = (
+                   fscanf(file, " %lu %lu", &range->nextPool, &range->endPool) == 2
+                && range->nextPool <= range->endPool
+            );
+        }
+
+        if (!success) {
+            terminateCheckpoint(checkpoint);
+        }
+    }
+
+    fclose(file);
+
+    return success ? 0 : -1;
+}
+
+
+static void checkpointFailed(char const* const operation, char const* const filename) {
+    /* A run that can no longer record its progress would restart from an older checkpoint without warning. */
+
+    fprintf(stderr, "*** Error: Unable to %s checkpoint %s: %s.\n", operation, filename, strerror(errno));
+    exit(1);
+}
+
+
+static void syncDirectory(char const* const filename) {
+    char* directory = strdup(filename);
+    char* separator;
+    int   descriptor;
+
+    assert(directory != NULL);
+
+    /* The rename is only durable once the directory entry reaches the disk. */
+
+    separator = strrchr(directory, '/');
+    if (separator == NULL) {
+        strcpy(directory, ".");
+    } else if (separator == directory) {
+        separator[1] = '\0';
+    } else {
+        separator[0] = '\0';
+    }
+
+    descriptor = open(directory, O_RDONLY | O_DIRECTORY);
+    if (descriptor < 0 || fsync(descriptor) != 0) {
+        checkpointFailed("sync the directory of", filename);
+    }
+
+    close(descriptor);
+    free(directory);
+}
+
+
+void writeCheckpoint(Checkpoint const* const checkpoint, char const* const filename) {
+    char*         temporaryFilename = malloc(strlen(filename) + 5);
+    FILE*         file;
+    unsigned long i;
+
+    assert(temporaryFilename != NULL);
+    sprintf(temporaryFilename, "%s.tmp", filename);
+
+    file = fopen(temporaryFilename, "w");
+    if (file == NULL) {
+        checkpointFailed("create", temporaryFilename);
+    }
+
+    fprintf(file, "sieve_of_eratosthenes_gf2 checkpoint %u\n", CHECKPOINT_VERSION);
+    fprintf(file, "maximum_prime %" PRIx64 "\n", checkpoint->maximumPrime);
+    fprintf(file, "pool_size_in_bytes %lu\n", checkpoint->poolSizeInBytes);
+    fprintf(file, "puddle_size %u\n", checkpoint->puddleSize);
+    fprintf(file, "segmented %d\n", checkpoint->segmented);
+    fprintf(file, "next_sieving_prime %lu\n", checkpoint->nextSievingPrime);
+    fprintf(file, "ranges %lu\n", checkpoint->numberRanges);
+
+    for (i=0 ; i<checkpoint->numberRanges ; ++i) {
+        fprintf(file, "%lu %lu\n", checkpoint->ranges[i].nextPool, checkpoint->ranges[i].endPool);
+    }
+
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0 || fclose(file) != 0) {
+        checkpointFailed("write", temporaryFilename);
+    }
+
+    if (rename(temporaryFilename, filename) != 0) {
+        checkpointFailed("replace", filename);
+    }
+
+    syncDirectory(filename);
+    free(temporaryFilename);
+}
+
+
+void terminateCheckpoint(Checkpoint* const checkpoint) {
+    free(checkpoint->ranges);
+
+    checkpoint->ranges       = NULL;
+    checkpoint->numberRanges = 0;
+}
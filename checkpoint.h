@@ -0,0 +1,100 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Checkpoints used to resume an interrupted sieve.
+*
+* This file defines functions used to record and recover the progress of a sieve.  A checkpoint is a small text file
+* holding the parameters of the run and how far the run has progressed.  Checkpoints are written to a temporary file
+* that is then renamed over the previous checkpoint so a crash always leaves either the old or the new checkpoint in
+* place.
+***********************************************************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "gf2.h"
+
+/*******************************************************************************************************************//**
+* \brief Range of pools owned by a single segmented sieve worker.
+*
+* You can use this structure to track which pools in a worker's range are still to be sieved.
+***********************************************************************************************************************/
+typedef struct CheckpointRange {
+    unsigned long nextPool;
+    unsigned long endPool;
+} CheckpointRange;
+
+/*******************************************************************************************************************//**
+* \brief Progress of a sieve.
+*
+* You can use this structure to hold the state needed to resume a sieve.  The segmented sieve records the pools still
+* to be sieved by each worker.  A pool is only recorded as complete once it has been written back to disk.  The prime
+* ordered sieve records the index of the next sieving prime to apply once every earlier prime has been flushed to disk.
+***********************************************************************************************************************/
+typedef struct Checkpoint {
+    Gf2Polynomial    maximumPrime;
+    unsigned long    poolSizeInBytes;
+    unsigned         puddleSize;
+    int              segmented;
+    unsigned long    nextSievingPrime;
+    unsigned long    numberRanges;
+    CheckpointRange* ranges;
+} Checkpoint;
+
+/*******************************************************************************************************************//**
+* \brief Initializes a checkpoint.
+*
+* You can use this function to initialize a checkpoint for a new run.  The ranges are allocated but not initialized.
+*
+* \param[out] checkpoint   The checkpoint to initialize.
+*
+* \param[in]  numberRanges The number of worker ranges to allocate.  Use 0 for the prime ordered sieve.
+***********************************************************************************************************************/
+void initializeCheckpoint(Checkpoint* const checkpoint, unsigned long const numberRanges);
+
+/*******************************************************************************************************************//**
+* \brief Reads a checkpoint.
+*
+* You can use this function to recover the checkpoint written by an earlier run.
+*
+* \param[out] checkpoint The checkpoint to initialize from the file.
+*
+* \param[in]  filename   The name of the checkpoint file.
+*
+* \return Returns 0 on success.  Returns -1 if the file does not exist or is not a valid checkpoint.  The checkpoint
+*         is left uninitialized on failure.
+***********************************************************************************************************************/
+int readCheckpoint(Checkpoint* const checkpoint, char const* const filename);
+
+/*******************************************************************************************************************//**
+* \brief Writes a checkpoint.
+*
+* You can use this function to atomically replace the checkpoint file.  The data is flushed to disk before the file
+* is renamed into place and the directory is flushed after the rename.  An error message is written to stderr and the
+* program exits if the checkpoint can not be written.
+*
+* \param[in] checkpoint The checkpoint to write.
+*
+* \param[in] filename   The name of the checkpoint file.
+***********************************************************************************************************************/
+void writeCheckpoint(Checkpoint const* const checkpoint, char const* const filename);
+
+/*******************************************************************************************************************//**
+* \brief Releases a checkpoint.
+*
+* \param[in] checkpoint The checkpoint to be released.
+***********************************************************************************************************************/
+void terminateCheckpoint(Checkpoint* const checkpoint);
+
+#endif
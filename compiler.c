@@ -25,6 +25,16 @@
 
 #if (!defined(__GNUC__))
 
+    int cpuSupportsCarrylessMultiply(void) {
+        return 0;
+    }
+
+
+    int cpuSupportsVectorPopcount(void) {
+        return 0;
+    }
+
+
     unsigned countLeadingZeros32(unsigned long const e) {
         unsigned offset = 0;
 
@@ -116,4 +126,15 @@
         return offset;
     }
 
+
+    unsigned countOnes64(unsigned long long const e) {
+        uint64_t v = e;
+
+        v = v - ((v >> 1) & 0x5555555555555555ULL);
+        v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+        v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+
+        return (unsigned) ((v * 0x0101010101010101ULL) >> 56);
+    }
+
 #endif
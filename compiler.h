@@ -32,6 +32,57 @@
 * inline functions.  The macro maps to the associated compiler function as needed.
 ***********************************************************************************************************************/
 
+/*******************************************************************************************************************//**
+* \def GF2PRIMES_API
+*
+* \brief Indicates a function exported by the gf2primes library.
+*
+* You can use this macro to mark the functions that make up the public interface of the gf2primes shared library.  The
+* library is built with hidden symbol visibility so every function without the marking stays internal to the library.
+***********************************************************************************************************************/
+
+/*******************************************************************************************************************//**
+* \fn static int cpuSupportsCarrylessMultiply(void)
+*
+* \brief Determines if the processor supports a carry-less multiply instruction.
+*
+* You can use this function to determine, at run-time, if the processor supports the PCLMULQDQ instruction.
+*
+* \return Returns a non-zero value if the instruction is supported.  Returns 0 if the instruction is not supported or
+*         if the check is not supported by this compiler or architecture.
+***********************************************************************************************************************/
+
+/*******************************************************************************************************************//**
+* \def TARGET_CARRYLESS_MULTIPLY
+*
+* \brief Indicates a function that may use the carry-less multiply instruction.
+*
+* You can use this macro to mark a function that uses carry-less multiply intrinsics.  The macro is only defined when
+* the compiler and architecture support the instruction.  Functions marked this way should only be called after
+* \ref cpuSupportsCarrylessMultiply reports that the instruction is available.
+***********************************************************************************************************************/
+
+/*******************************************************************************************************************//**
+* \fn static int cpuSupportsVectorPopcount(void)
+*
+* \brief Determines if the processor supports the vector instructions used to count bits in bulk.
+*
+* You can use this function to determine, at run-time, if the processor and operating system support AVX2.
+*
+* \return Returns a non-zero value if the instructions are supported.  Returns 0 if the instructions are not supported
+*         or if the check is not supported by this compiler or architecture.
+***********************************************************************************************************************/
+
+/*******************************************************************************************************************//**
+* \def TARGET_VECTOR_POPCOUNT
+*
+* \brief Indicates a function that may use the vector instructions used to count bits in bulk.
+*
+* You can use this macro to mark a function that uses AVX2 intrinsics.  The macro is only defined when the compiler and
+* architecture support the instructions.  Functions marked this way should only be called after
+* \ref cpuSupportsVectorPopcount reports that the instructions are available.
+***********************************************************************************************************************/
+
 /*******************************************************************************************************************//**
 * \fn static unsigned countLeadingZeros32(unsigned long const v)
 *
@@ -84,9 +135,58 @@
 *         0x8000000000000000 will return 63.  A value of 0 returns 64.
 ***********************************************************************************************************************/
 
+/*******************************************************************************************************************//**
+* \fn static unsigned countOnes64(unsigned long long const v)
+*
+* \brief Determines the number of set bits in a number.
+*
+* You can use this function to calculate the population count of an arbitrary 64-bit number.
+*
+* \param[in] v The value to calculate the number of set bits for.
+*
+* \return Returns the number of set bits.  The value 0xFFFFFFFFFFFFFFFF will return 64.  A value of 0 returns 0.
+***********************************************************************************************************************/
+
 #if (defined(__GNUC__))
 
     #define INLINE __inline__ static
+    #define GF2PRIMES_API __attribute__((visibility("default")))
+
+    #if (defined(__x86_64__))
+
+        #include <cpuid.h>
+
+        #define TARGET_CARRYLESS_MULTIPLY __attribute__((target("pclmul,sse2")))
+
+        INLINE int cpuSupportsCarrylessMultiply(void) {
+            unsigned eax;
+            unsigned ebx;
+            unsigned ecx;
+            unsigned edx;
+
+            return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) != 0;
+        }
+
+        #define TARGET_VECTOR_POPCOUNT __attribute__((target("avx2")))
+
+        INLINE int cpuSupportsVectorPopcount(void) {
+            /* Unlike a raw CPUID check, the builtin also confirms the operating system saves the AVX registers. */
+
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        }
+
+    #else
+
+        INLINE int cpuSupportsCarrylessMultiply(void) {
+            return 0;
+        }
+
+        INLINE int cpuSupportsVectorPopcount(void) {
+            return 0;
+        }
+
+    #endif
 
     INLINE unsigned countLeadingZeros32(unsigned long const v) {
         return v == 0 ? 32 : __builtin_clzl(v);
@@ -104,12 +204,21 @@
         return v == 0 ? 64 : __builtin_ctzl(v);
     }
 
+    INLINE unsigned countOnes64(unsigned long long const v) {
+        return __builtin_popcountll(v);
+    }
+
 #else
 
+    #define GF2PRIMES_API
+
+    int      cpuSupportsCarrylessMultiply(void);
+    int      cpuSupportsVectorPopcount(void);
     unsigned countLeadingZeros32(unsigned long const v);
     unsigned countLeadingZeros64(unsigned long long const v);
     unsigned countTrailingZeros32(unsigned long const v);
     unsigned countTrailingZeros64(unsigned long long const v);
+    unsigned countOnes64(unsigned long long const v);
 
 #endif
 
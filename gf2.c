@@ -21,27 +21,132 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 #include "compiler.h"
 #include "debug.h"
 #include "gf2.h"
 
 
-Gf2Polynomial gf2Multiply(Gf2Polynomial const p1, Gf2Polynomial const p2) {
-    Gf2Polynomial product = 0;
-    Gf2Polynomial s1      = p1;
-    Gf2Polynomial s2      = p2;
+#if (defined(TARGET_CARRYLESS_MULTIPLY))
+
+    #include <wmmintrin.h>
+
+#endif
+
+
+typedef Gf2Polynomial (*MultiplyFunction)(Gf2Polynomial const, Gf2Polynomial const, Gf2Polynomial*);
+
+
+static Gf2Polynomial multiplyShiftAndAdd(Gf2Polynomial const p1, Gf2Polynomial const p2, Gf2Polynomial* high) {
+    Gf2Polynomial productLow  = 0;
+    Gf2Polynomial productHigh = 0;
+    Gf2Polynomial s2          = p2;
+    unsigned      shift       = 0;
 
     while (s2) {
         if (s2 & 1) {
-            product ^= s1;
+            productLow ^= p1 << shift;
+
+            if (shift != 0) {
+                productHigh ^= p1 >> (64 - shift);
+            }
         }
 
         s2 >>= 1;
-        s1 <<= 1;
+        ++shift;
+    }
+
+    if (high != NULL) {
+        *high = productHigh;
     }
 
-    return product;
+    return productLow;
+}
+
+
+#if (defined(TARGET_CARRYLESS_MULTIPLY))
+
+    TARGET_CARRYLESS_MULTIPLY static Gf2Polynomial multiplyCarryless(
+            Gf2Polynomial const p1,
+            Gf2Polynomial const p2,
+            Gf2Polynomial*      high
+        ) {
+        __m128i product = _mm_clmulepi64_si128(
+            _mm_cvtsi64_si128((long long) p1),
+            _mm_cvtsi64_si128((long long) p2),
+            0x00
+        );
+
+        if (high != NULL) {
+            *high = (Gf2Polynomial) _mm_cvtsi128_si64(_mm_unpackhi_epi64(product, product));
+        }
+
+        return (Gf2Polynomial) _mm_cvtsi128_si64(product);
+    }
+
+#endif
+
+
+static Gf2Polynomial multiplySelect(Gf2Polynomial const p1, Gf2Polynomial const p2, Gf2Polynomial* high);
+
+/* The implementation is selected once, on first use, under multiplyOnce.  Threads that still see multiplySelect wait
+ * for the selection inside pthread_once so the name is only read once it has been written. */
+
+static pthread_once_t            multiplyOnce     = PTHREAD_ONCE_INIT;
+static _Atomic(MultiplyFunction) multiplyFunction = &multiplySelect;
+static char const*               multiplyName     = NULL;
+
+
+static void selectMultiplyFunction(void) {
+    MultiplyFunction function;
+
+    #if (defined(TARGET_CARRYLESS_MULTIPLY))
+
+        if (cpuSupportsCarrylessMultiply()) {
+            multiplyName = "pclmulqdq";
+            function     = &multiplyCarryless;
+        } else {
+            multiplyName = "shift-and-add";
+            function     = &multiplyShiftAndAdd;
+        }
+
+    #else
+
+        multiplyName = "shift-and-add";
+        function     = &multiplyShiftAndAdd;
+
+    #endif
+
+    atomic_store_explicit(&multiplyFunction, function, memory_order_release);
+}
+
+
+INLINE MultiplyFunction currentMultiplyFunction(void) {
+    return atomic_load_explicit(&multiplyFunction, memory_order_relaxed);
+}
+
+
+static Gf2Polynomial multiplySelect(Gf2Polynomial const p1, Gf2Polynomial const p2, Gf2Polynomial* high) {
+    pthread_once(&multiplyOnce, &selectMultiplyFunction);
+    return (*currentMultiplyFunction())(p1, p2, high);
+}
+
+
+Gf2Polynomial gf2Multiply(Gf2Polynomial const p1, Gf2Polynomial const p2) {
+    return (*currentMultiplyFunction())(p1, p2, NULL);
+}
+
+
+Gf2Polynomial gf2MultiplyWide(Gf2Polynomial const p1, Gf2Polynomial const p2, Gf2Polynomial* optionalHigh) {
+    return (*currentMultiplyFunction())(p1, p2, optionalHigh);
+}
+
+
+char const* gf2MultiplyImplementation(void) {
+    pthread_once(&multiplyOnce, &selectMultiplyFunction);
+    return multiplyName;
 }
 
 
@@ -85,3 +190,63 @@ Gf2Polynomial gf2Remainder(Gf2Polynomial const dividend, Gf2Polynomial const div
 
     return remainder;
 }
+
+
+void gf2MultiplesStart(
+        Gf2MultipleIterator* const iterator,
+        Gf2Polynomial const        factor,
+        unsigned const             minimumMultiplierDegree,
+        Gf2Polynomial const        limit,
+        int const                  oddMultipliersOnly
+    ) {
+    assert(factor != 0);
+    assert(!oddMultipliersOnly || minimumMultiplierDegree > 0);
+
+    iterator->factor                  = factor;
+    iterator->limit                   = limit;
+    iterator->base                    = 0;
+    iterator->multiplier              = 0;
+    iterator->product                 = 0;
+    iterator->step                    = 0;
+    iterator->bandSteps               = 0;
+    iterator->factorDegree            = gf2Degree(factor);
+    iterator->multiplierDegree        = minimumMultiplierDegree - 1;
+    iterator->maximumMultiplierDegree = 63;
+    iterator->firstFreeBit            = oddMultipliersOnly ? 1 : 0;
+    iterator->lowBit                  = oddMultipliersOnly ? 1 : 0;
+}
+
+
+void gf2MultiplesInBlockStart(
+        Gf2MultipleIterator* const iterator,
+        Gf2Polynomial const        factor,
+        Gf2Polynomial const        blockStart,
+        unsigned const             blockSizeLog2
+    ) {
+    unsigned      factorDegree = gf2Degree(factor);
+    unsigned      bandDegree   = blockSizeLog2 - factorDegree;
+    Gf2Polynomial firstMultiple;
+
+    assert((factor & 1) != 0);
+    assert(factorDegree < blockSizeLog2 && blockSizeLog2 < 64);
+    assert((blockStart & (((Gf2Polynomial) 1 << blockSizeLog2) - 1)) == 0);
+
+    /* The multiples of p in the block are blockStart + (blockStart mod p) + p*r with deg(r) < bandDegree.  Writing
+     * r = q + x^bandDegree lets the iterator walk a single band of degree bandDegree offset by base.  The x^0 term of
+     * q is pinned so that every product is odd. */
+
+    firstMultiple = blockStart ^ gf2Remainder(blockStart, factor);
+
+    iterator->factor                  = factor;
+    iterator->limit                   = (Gf2Polynomial) -1;
+    iterator->base                    = firstMultiple ^ (factor << bandDegree);
+    iterator->multiplier              = 0;
+    iterator->product                 = 0;
+    iterator->step                    = 0;
+    iterator->bandSteps               = 0;
+    iterator->factorDegree            = factorDegree;
+    iterator->multiplierDegree        = bandDegree - 1;
+    iterator->maximumMultiplierDegree = bandDegree;
+    iterator->firstFreeBit            = 1;
+    iterator->lowBit                  = (firstMultiple & 1) ^ 1;
+}
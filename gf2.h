@@ -30,6 +30,42 @@
 ***********************************************************************************************************************/
 typedef uint64_t Gf2Polynomial;
 
+/*******************************************************************************************************************//**
+* \brief Iterator used to enumerate the multiples of a polynomial.
+*
+* You can use this structure to walk the multiples p*q of a fixed polynomial p.  The multipliers q are visited in
+* Gray-code order within each degree band so that each product differs from the previous one by a single shifted copy
+* of p.  Use \ref gf2MultiplesStart or \ref gf2MultiplesInBlockStart to initialize the iterator and
+* \ref gf2MultiplesNext to advance it.
+***********************************************************************************************************************/
+typedef struct Gf2MultipleIterator {
+    Gf2Polynomial factor;
+    Gf2Polynomial limit;
+    Gf2Polynomial base;
+    Gf2Polynomial multiplier;
+    Gf2Polynomial product;
+    uint64_t      step;
+    uint64_t      bandSteps;
+    unsigned      factorDegree;
+    unsigned      multiplierDegree;
+    unsigned      maximumMultiplierDegree;
+    unsigned      firstFreeBit;
+    unsigned      lowBit;
+} Gf2MultipleIterator;
+
+/*******************************************************************************************************************//**
+* \brief Function that determines the degree of a polynomial.
+*
+* You can use this function to determine the degree of a non-zero polynomial.
+*
+* \param[in] p The polynomial to check.  The value must not be 0.
+*
+* \return Returns the degree of the highest order term.
+***********************************************************************************************************************/
+INLINE unsigned gf2Degree(Gf2Polynomial const p) {
+    return 63 - countLeadingZeros64(p);
+}
+
 /*******************************************************************************************************************//**
 * \brief Function that adds two polynomials in a GF(2) field.
 *
@@ -48,7 +84,9 @@ INLINE Gf2Polynomial gf2Add(Gf2Polynomial const p1, Gf2Polynomial const p2) {
 /***********************************************************************************************************************
 * \brief Function that multiplies two polynomials in a GF(2) field.
 *
-* You can use this function to multiply two polynomials in a GF(2) field.
+* You can use this function to multiply two polynomials in a GF(2) field.  The function uses the processor's carry-less
+* multiply instruction when available and falls back to a portable shift and exclusive-or loop otherwise.  Terms of the
+* product above x^63 are discarded.
 *
 * \param[in] p1 The first polynomial to multiply.
 *
@@ -56,7 +94,37 @@ INLINE Gf2Polynomial gf2Add(Gf2Polynomial const p1, Gf2Polynomial const p2) {
 *
 * \return Returns the product.
 ***********************************************************************************************************************/
-Gf2Polynomial gf2Multiply(Gf2Polynomial const p1, Gf2Polynomial const p2);
+GF2PRIMES_API Gf2Polynomial gf2Multiply(Gf2Polynomial const p1, Gf2Polynomial const p2);
+
+/***********************************************************************************************************************
+* \brief Function that multiplies two polynomials in a GF(2) field, retaining the full 128-bit product.
+*
+* You can use this function to multiply two polynomials in a GF(2) field when the product may exceed 64 bits.  The
+* implementation is selected the same way as for \ref gf2Multiply.
+*
+* \param[in]  p1           The first polynomial to multiply.
+*
+* \param[in]  p2           The second polynomial to multiply.
+*
+* \param[out] optionalHigh Optional pointer to the terms x^64 through x^127 of the product.
+*
+* \return Returns the terms x^0 through x^63 of the product.
+***********************************************************************************************************************/
+GF2PRIMES_API Gf2Polynomial gf2MultiplyWide(
+    Gf2Polynomial const p1,
+    Gf2Polynomial const p2,
+    Gf2Polynomial*      optionalHigh
+);
+
+/***********************************************************************************************************************
+* \brief Function that reports the multiply implementation in use.
+*
+* You can use this function to determine which implementation was selected for \ref gf2Multiply and
+* \ref gf2MultiplyWide on this processor.
+*
+* \return Returns a short, human readable name for the implementation.
+***********************************************************************************************************************/
+GF2PRIMES_API char const* gf2MultiplyImplementation(void);
 
 /***********************************************************************************************************************
 * \brief Function that divides two polynomials in a GF(2) field.
@@ -71,7 +139,11 @@ Gf2Polynomial gf2Multiply(Gf2Polynomial const p1, Gf2Polynomial const p2);
 *
 * \returns the quotient of the division.
 ***********************************************************************************************************************/
-Gf2Polynomial gf2Divide(Gf2Polynomial const dividend, Gf2Polynomial const divisor, Gf2Polynomial* optionalRemainder);
+GF2PRIMES_API Gf2Polynomial gf2Divide(
+    Gf2Polynomial const dividend,
+    Gf2Polynomial const divisor,
+    Gf2Polynomial*      optionalRemainder
+);
 
 /***********************************************************************************************************************
 * \brief Function that divides two polynomials in a GF(2) field and calculates just the remainder.
@@ -84,6 +156,101 @@ Gf2Polynomial gf2Divide(Gf2Polynomial const dividend, Gf2Polynomial const diviso
 *
 * \return Returns the remainder.
 ***********************************************************************************************************************/
-Gf2Polynomial gf2Remainder(Gf2Polynomial const dividend, Gf2Polynomial const divisor);
+GF2PRIMES_API Gf2Polynomial gf2Remainder(Gf2Polynomial const dividend, Gf2Polynomial const divisor);
+
+/***********************************************************************************************************************
+* \brief Function that prepares an iterator to walk the multiples of a polynomial.
+*
+* You can use this function to initialize a \ref Gf2MultipleIterator.  The iterator will visit every product p*q with
+* deg(q) >= minimumMultiplierDegree and p*q <= limit exactly once.  Products are not visited in increasing order.
+*
+* \param[out] iterator                The iterator to initialize.
+*
+* \param[in]  factor                  The polynomial, p, whose multiples should be enumerated.  The value must not be 0.
+*
+* \param[in]  minimumMultiplierDegree The lowest degree multiplier to consider.
+*
+* \param[in]  limit                   The largest product to report.
+*
+* \param[in]  oddMultipliersOnly      If non-zero, only multipliers with a non-zero x^0 term are considered.
+***********************************************************************************************************************/
+GF2PRIMES_API void gf2MultiplesStart(
+    Gf2MultipleIterator* const iterator,
+    Gf2Polynomial const        factor,
+    unsigned const             minimumMultiplierDegree,
+    Gf2Polynomial const        limit,
+    int const                  oddMultipliersOnly
+);
+
+/***********************************************************************************************************************
+* \brief Function that prepares an iterator to walk the odd multiples of a polynomial inside an aligned block.
+*
+* You can use this function to initialize a \ref Gf2MultipleIterator that visits every odd multiple of an odd
+* polynomial p in the range [blockStart, blockStart + 2^blockSizeLog2).  The multiples form a coset of the multiples of
+* p with degree below blockSizeLog2, so they can be walked in Gray-code order just like \ref gf2MultiplesStart.  The
+* iterator's multiplier member is relative to the first multiple in the block.
+*
+* \param[out] iterator      The iterator to initialize.
+*
+* \param[in]  factor        The polynomial, p, whose multiples should be enumerated.  The value must be odd and its
+*                           degree must be less than blockSizeLog2.
+*
+* \param[in]  blockStart    The first value in the block.  The value must be a multiple of 2^blockSizeLog2.
+*
+* \param[in]  blockSizeLog2 The base 2 log of the number of values in the block.
+***********************************************************************************************************************/
+GF2PRIMES_API void gf2MultiplesInBlockStart(
+    Gf2MultipleIterator* const iterator,
+    Gf2Polynomial const        factor,
+    Gf2Polynomial const        blockStart,
+    unsigned const             blockSizeLog2
+);
+
+/***********************************************************************************************************************
+* \brief Function that advances an iterator to the next multiple.
+*
+* You can use this function to obtain the next product from a \ref Gf2MultipleIterator.  Each step costs a single
+* shift and exclusive-or.  The multiplier for the returned product is available in the iterator's multiplier member.
+*
+* \param[in,out] iterator The iterator to advance.
+*
+* \return Returns the next product.  A value of 0 is returned once every product has been reported.
+***********************************************************************************************************************/
+INLINE Gf2Polynomial gf2MultiplesNext(Gf2MultipleIterator* const iterator) {
+    do {
+        ++iterator->step;
+
+        if (iterator->step < iterator->bandSteps) {
+            unsigned bit = iterator->firstFreeBit + countTrailingZeros64(iterator->step);
+
+            iterator->product    ^= iterator->factor << bit;
+            iterator->multiplier ^= (Gf2Polynomial) 1 << bit;
+        } else {
+            unsigned degree        = iterator->multiplierDegree + 1;
+            unsigned productDegree = iterator->factorDegree + degree;
+
+            if (degree > iterator->maximumMultiplierDegree                ||
+                productDegree > 63                                        ||
+                ((Gf2Polynomial) 1 << productDegree) > iterator->limit       ) {
+                iterator->step      = 0;
+                iterator->bandSteps = 0;
+
+                return 0;
+            }
+
+            iterator->multiplierDegree = degree;
+            iterator->multiplier       = ((Gf2Polynomial) 1 << degree) | iterator->lowBit;
+            iterator->product          = (
+                  iterator->base
+                ^ (iterator->factor << degree)
+                ^ (iterator->lowBit ? iterator->factor : 0)
+            );
+            iterator->step             = 0;
+            iterator->bandSteps        = (uint64_t) 1 << (degree - iterator->firstFreeBit);
+        }
+    } while (iterator->product > iterator->limit);
+
+    return iterator->product;
+}
 
 #endif
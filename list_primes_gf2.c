@@ -30,10 +30,15 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
 
 #include "compiler.h"
 #include "gf2.h"
 #include "prime_list.h"
+#include "prime_format.h"
+#include "prime_output.h"
+#include "popcount.h"
+#include "cmdline.h"
 
 #include "parameters.h"
 
@@ -45,18 +50,667 @@
 ***********************************************************************************************************************/
 #define VERSION ("1.0")
 
+/*******************************************************************************************************************//**
+* \brief Indicates the help text displayed by the --help switch.
+*
+* You can use this define to describe the switches supported by this program.  The maximum prime, pool size, and
+* puddle size are read from the container.  By default every prime is listed in hexadecimal.  The binary formats are
+* described in prime_format.h and can be decoded with the prime reader library.
+***********************************************************************************************************************/
+#define HELP_TEXT \
+    "Usage: list_primes_gf2 [switches]\n" \
+    "\n" \
+    "Switches:\n" \
+    "    --cache-size <bytes>     Memory budget for the pools kept resident.\n" \
+    "    --memory-map             Memory map the pools instead of reading whole pools.\n" \
+    "    --prefix <prefix>        Prefix used to name the container file.\n" \
+    "    --degree <degree>        List only the primes of a single degree.\n" \
+    "    --from <value>           List only the primes greater than or equal to a value.\n" \
+    "    --to <value>             List only the primes less than or equal to a value.\n" \
+    "    --format <format>        Write the primes as hex, u64le, or delta-varint.  The default is hex.\n" \
+    "    --threads <count>        Number of listing threads, 0 for one per processor.  Implies --memory-map.\n" \
+    "    --count-up-to <value>    Report the number of primes up to a value instead of listing them.\n" \
+    "    --nth-prime <n>          Report the nth prime, counting 2 as the first, instead of listing them.\n" \
+    "    --count-by-degree        Count the primes of each degree and check the counts against the necklace\n" \
+    "                             formula instead of listing them.\n" \
+    "    --help                   Display this text."
+
+
+/*******************************************************************************************************************//**
+* \brief Parses a polynomial supplied on the command line.
+*
+* You can use this function to convert a switch value in decimal, octal or hexadecimal notation.  An error message is
+* written to stderr if the value is invalid.
+*
+* \param[in]  text  The text to convert.
+*
+* \param[out] value The converted value.
+*
+* \return Returns 0 on success.  Returns -1 if the text is not a valid value.
+***********************************************************************************************************************/
+static int parseValue(char const* const text, Gf2Polynomial* const value) {
+    char* endPointer;
+
+    errno  = 0;
+    *value = strtoull(text, &endPointer, 0);
+    if (*text == '\0' || *text == '-' || *endPointer != '\0' || errno != 0) {
+        fprintf(stderr, "*** Error: Invalid value \"%s\".\n", text);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief State shared by the parallel listing threads.
+*
+* You can use this structure to hand out chunks of the range being listed and to pass the formatted chunks back in
+* order.  Chunk c is formatted into slot c modulo the number of slots so at most one chunk per slot is held in memory.
+***********************************************************************************************************************/
+typedef struct ListSequencer {
+    PrimeList*      primeList;
+    Gf2Polynomial   firstBit;
+    Gf2Polynomial   endBit;
+    Gf2Polynomial   chunkBaseBit;
+    Gf2Polynomial   bitsPerChunk;
+    unsigned long   numberChunks;
+    unsigned long   nextChunk;
+    unsigned long   nextEmittedChunk;
+    unsigned long   numberSlots;
+    PrimeOutput**   slots;
+    int*            slotIsReady;
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+} ListSequencer;
+
+
+/*******************************************************************************************************************//**
+* \brief Writes the primes tracked by a range of bits.
+*
+* You can use this function to format the primes held by every pool that overlaps a range of bits.  Bit i tracks the
+* value 2 * i + 1.  Pools whose summary shows no primes in the range are skipped.
+*
+* \param[in]     primeList   The prime list to read.
+*
+* \param[in,out] primeOutput The prime output to update.
+*
+* \param[in]     firstBit    The first bit to scan.
+*
+* \param[in]     endBit      One past the last bit to scan.
+***********************************************************************************************************************/
+static void writeRange(
+        PrimeList* const    primeList,
+        PrimeOutput* const  primeOutput,
+        Gf2Polynomial const firstBit,
+        Gf2Polynomial const endBit
+    ) {
+    unsigned long lastPool = primeListPoolIndex(primeList, 2 * endBit - 1);
+    unsigned long poolIndex;
+
+    for (poolIndex=primeListPoolIndex(primeList, 2 * firstBit + 1) ; poolIndex<=lastPool ; ++poolIndex) {
+        Gf2Polynomial        poolFirstValue;
+        Gf2Polynomial        poolLastValue;
+        Gf2Polynomial        poolFirstBit;
+        Gf2Polynomial        scanFirstBit;
+        Gf2Polynomial        scanEndBit;
+        PrimeListPoolSummary summary;
+
+        primeListPoolBounds(primeList, poolIndex, &poolFirstValue, &poolLastValue);
+        poolFirstBit = poolFirstValue >> 1;
+        scanFirstBit = firstBit > poolFirstBit ? firstBit : poolFirstBit;
+        scanEndBit   = endBit < (poolLastValue >> 1) + 1 ? endBit : (poolLastValue >> 1) + 1;
+
+        /* The summary bounds the primes of the pool so the scan starts at the pool's first prime and pools holding no
+         * primes in the range are never read. */
+
+        if (primeListPoolSummary(primeList, poolIndex, &summary) == 0) {
+            if (summary.numberPrimes == 0) {
+                scanEndBit = scanFirstBit;
+            } else {
+                if (scanFirstBit < (summary.firstPrime >> 1)) {
+                    scanFirstBit = summary.firstPrime >> 1;
+                }
+
+                if (scanEndBit > (summary.lastPrime >> 1) + 1) {
+                    scanEndBit = (summary.lastPrime >> 1) + 1;
+                }
+            }
+        }
+
+        if (scanFirstBit < scanEndBit) {
+            writePoolPrimes(
+                primeOutput,
+                primeListPoolWords(primeList, poolIndex),
+                scanFirstBit - poolFirstBit,
+                scanEndBit - poolFirstBit,
+                poolFirstValue + 1
+            );
+        }
+    }
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Thread formatting chunks of the range being listed.
+*
+* You can use this function to format chunks in parallel.  A chunk is only claimed once its slot has been emitted so
+* the threads never run more than one slot per chunk ahead of the output.
+*
+* \param[in] argument Pointer to the shared \ref ListSequencer instance.
+*
+* \return Returns NULL.
+***********************************************************************************************************************/
+static void* listWorkerThread(void* argument) {
+    ListSequencer* sequencer = (ListSequencer*) argument;
+    int            done      = 0;
+
+    while (!done) {
+        unsigned long chunk;
+
+        pthread_mutex_lock(&sequencer->lock);
+        while (sequencer->nextChunk < sequencer->numberChunks
+               && sequencer->nextChunk >= sequencer->nextEmittedChunk + sequencer->numberSlots) {
+            pthread_cond_wait(&sequencer->changed, &sequencer->lock);
+        }
+
+        chunk = sequencer->nextChunk;
+        done  = chunk >= sequencer->numberChunks;
+        if (!done) {
+            ++sequencer->nextChunk;
+        }
+
+        pthread_mutex_unlock(&sequencer->lock);
+
+        if (!done) {
+            unsigned long slot       = chunk % sequencer->numberSlots;
+            Gf2Polynomial chunkFirst = sequencer->chunkBaseBit + chunk * sequencer->bitsPerChunk;
+            Gf2Polynomial chunkEnd   = chunkFirst + sequencer->bitsPerChunk;
+
+            if (chunkFirst < sequencer->firstBit) {
+                chunkFirst = sequencer->firstBit;
+            }
+
+            if (chunkEnd > sequencer->endBit) {
+                chunkEnd = sequencer->endBit;
+            }
+
+            writeRange(sequencer->primeList, sequencer->slots[slot], chunkFirst, chunkEnd);
+
+            pthread_mutex_lock(&sequencer->lock);
+            sequencer->slotIsReady[slot] = 1;
+            pthread_cond_broadcast(&sequencer->changed);
+            pthread_mutex_unlock(&sequencer->lock);
+        }
+    }
+
+    return NULL;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Writes the primes tracked by a range of bits using several threads.
+*
+* You can use this function to list a large range on several processors.  The range is cut into chunks aligned to
+* LIST_CHUNK_SIZE_IN_BYTES of pool data.  Worker threads format the chunks into their own buffers and this thread
+* appends the buffers to the output in ascending order, so the output is identical to a single threaded listing.  The
+* prime list must be a read-only handle with every pool mapped.
+*
+* \param[in]     primeList     The prime list to read.
+*
+* \param[in,out] primeOutput   The prime output to update.
+*
+* \param[in]     firstBit      The first bit to scan.
+*
+* \param[in]     endBit        One past the last bit to scan.
+*
+* \param[in]     format        The format of the prime output.
+*
+* \param[in]     numberThreads The number of worker threads to use.
+***********************************************************************************************************************/
+static void writeRangeInParallel(
+        PrimeList* const    primeList,
+        PrimeOutput* const  primeOutput,
+        Gf2Polynomial const firstBit,
+        Gf2Polynomial const endBit,
+        PrimeFormat const   format,
+        unsigned long const numberThreads
+    ) {
+    ListSequencer sequencer;
+    pthread_t*    threads;
+    unsigned long chunk;
+    unsigned long i;
+
+    sequencer.primeList        = primeList;
+    sequencer.firstBit         = firstBit;
+    sequencer.endBit           = endBit;
+    sequencer.bitsPerChunk     = 8 * (Gf2Polynomial) LIST_CHUNK_SIZE_IN_BYTES;
+    sequencer.chunkBaseBit     = firstBit - firstBit % sequencer.bitsPerChunk;
+    sequencer.numberChunks     = (endBit - sequencer.chunkBaseBit - 1) / sequencer.bitsPerChunk + 1;
+    sequencer.nextChunk        = 0;
+    sequencer.nextEmittedChunk = 0;
+    sequencer.numberSlots      = 2 * numberThreads;
+    sequencer.slots            = malloc(sequencer.numberSlots * sizeof(PrimeOutput*));
+    sequencer.slotIsReady      = calloc(sequencer.numberSlots, sizeof(int));
+    threads                    = malloc(numberThreads * sizeof(pthread_t));
+    assert(sequencer.slots != NULL && sequencer.slotIsReady != NULL && threads != NULL);
+
+    pthread_mutex_init(&sequencer.lock, NULL);
+    pthread_cond_init(&sequencer.changed, NULL);
+
+    /* The slots grow to fit the largest chunk they are given. */
+
+    for (i=0 ; i<sequencer.numberSlots ; ++i) {
+        sequencer.slots[i] = createPrimeOutput(-1, format, 64 * 1024);
+    }
+
+    for (i=0 ; i<numberThreads ; ++i) {
+        pthread_create(threads + i, NULL, &listWorkerThread, &sequencer);
+    }
+
+    for (chunk=0 ; chunk<sequencer.numberChunks ; ++chunk) {
+        unsigned long slot = chunk % sequencer.numberSlots;
+
+        pthread_mutex_lock(&sequencer.lock);
+        while (!sequencer.slotIsReady[slot]) {
+            pthread_cond_wait(&sequencer.changed, &sequencer.lock);
+        }
+
+        pthread_mutex_unlock(&sequencer.lock);
+
+        appendPrimeOutput(primeOutput, sequencer.slots[slot]);
+
+        pthread_mutex_lock(&sequencer.lock);
+        sequencer.slotIsReady[slot] = 0;
+        ++sequencer.nextEmittedChunk;
+        pthread_cond_broadcast(&sequencer.changed);
+        pthread_mutex_unlock(&sequencer.lock);
+    }
+
+    for (i=0 ; i<numberThreads ; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (i=0 ; i<sequencer.numberSlots ; ++i) {
+        destroyPrimeOutput(sequencer.slots[i]);
+    }
+
+    pthread_cond_destroy(&sequencer.changed);
+    pthread_mutex_destroy(&sequencer.lock);
+
+    free(threads);
+    free(sequencer.slotIsReady);
+    free(sequencer.slots);
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Writes the primes in a range to stdout.
+*
+* You can use this function to dump part of the prime list in the requested format.  Only the pools that overlap the
+* range are loaded.  Each pool is scanned a word at a time and the output is written in large blocks rather than one
+* line at a time.
+*
+* \param[in] primeList     The prime list to dump.
+*
+* \param[in] firstValue    The smallest value to list.
+*
+* \param[in] lastValue     The largest value to list.  Values past the maximum prime are ignored.
+*
+* \param[in] format        The format used to encode the primes.
+*
+* \param[in] numberThreads The number of threads used to format the primes.  Using more than one thread requires a
+*                          read-only handle with every pool mapped.
+*
+* \return Returns 0 on success.  Returns -1 if the output could not be written.
+***********************************************************************************************************************/
+static int listPrimes(
+        PrimeList* const    primeList,
+        Gf2Polynomial const firstValue,
+        Gf2Polynomial       lastValue,
+        PrimeFormat const   format,
+        unsigned long const numberThreads
+    ) {
+    PrimeOutput*  primeOutput = createPrimeOutput(STDOUT_FILENO, format, OUTPUT_BUFFER_SIZE_IN_BYTES);
+    Gf2Polynomial firstBit;
+    Gf2Polynomial endBit;
+
+    if (lastValue > primeListMaximumPrime(primeList)) {
+        lastValue = primeListMaximumPrime(primeList);
+    }
+
+    /* Only odd values are tracked by the pools so 2 is written first.  Bit i tracks the value 2 * i + 1 so the range
+     * covers the bits from the first odd value at or above firstValue through the last odd value at or below
+     * lastValue. */
+
+    if (firstValue <= 2 && lastValue >= 2) {
+        writePrime(primeOutput, 2);
+    }
+
+    firstBit = firstValue >> 1;
+    endBit   = (lastValue + 1) >> 1;
+
+    if (firstBit < endBit) {
+        advisePrimeList(primeList, PRIME_LIST_ACCESS_SEQUENTIAL);
+
+        if (numberThreads > 1) {
+            writeRangeInParallel(primeList, primeOutput, firstBit, endBit, format, numberThreads);
+        } else {
+            Gf2Polynomial lastPoolFirstValue;
+            Gf2Polynomial lastPoolLastValue;
+            Gf2Polynomial splitBit;
+
+            /* Sequential access reads the next pool in the background.  The advice is dropped before the last pool so
+             * the pool past the range is never read. */
+
+            primeListPoolBounds(
+                primeList,
+                primeListPoolIndex(primeList, 2 * endBit - 1),
+                &lastPoolFirstValue,
+                &lastPoolLastValue
+            );
+
+            splitBit = lastPoolFirstValue >> 1 > firstBit ? lastPoolFirstValue >> 1 : firstBit;
+
+            if (splitBit > firstBit) {
+                writeRange(primeList, primeOutput, firstBit, splitBit);
+            }
+
+            advisePrimeList(primeList, PRIME_LIST_ACCESS_NORMAL);
+            writeRange(primeList, primeOutput, splitBit, endBit);
+        }
+    }
+
+    return destroyPrimeOutput(primeOutput);
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Determines the number of irreducible polynomials of a degree.
+*
+* You can use this function to calculate the number of monic irreducible polynomials of degree n over GF(2) using the
+* necklace formula (1/n) * sum over d dividing n of mu(d) * 2^(n/d), where mu is the Moebius function.
+*
+* \param[in] n The degree, between 1 and 63.
+*
+* \return Returns the number of irreducible polynomials of degree n.
+***********************************************************************************************************************/
+static unsigned long long necklaceCount(unsigned const n) {
+    unsigned long long positive = 0;
+    unsigned long long negative = 0;
+    unsigned           d;
+
+    /* The positive and negative terms are summed apart so no partial sum exceeds 2^64. */
+
+    for (d=1 ; d<=n ; ++d) {
+        if (n % d == 0) {
+            unsigned remaining = d;
+            unsigned factor;
+            int      mu        = 1;
+
+            for (factor=2 ; factor<=remaining ; ++factor) {
+                if (remaining % factor == 0) {
+                    remaining /= factor;
+                    mu         = remaining % factor == 0 ? 0 : -mu;
+                }
+            }
+
+            if (mu > 0) {
+                positive += 1ULL << (n / d);
+            } else if (mu < 0) {
+                negative += 1ULL << (n / d);
+            }
+        }
+    }
+
+    return (positive - negative) / n;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Counts the primes of each degree and checks the counts.
+*
+* You can use this function to validate a prime list without listing it.  The values of degree n occupy the bits from
+* 2^(n-1) up to 2^n in the odd-only layout, so each degree is a band of whole pool words for every degree of 7 or more.
+* The clear bits of each band are counted in bulk and compared against \ref necklaceCount.  A table with the degree,
+* the count, the expected count, and the status of each band is written to stdout.  A band cut short by the maximum
+* prime, including the empty last band of a maximum prime that is a power of two, is reported as partial and is not
+* checked.
+*
+* \param[in] primeList The prime list to check.
+*
+* \return Returns 0 if every complete band matches.  Returns -1 if any band does not match.
+***********************************************************************************************************************/
+static int countByDegree(PrimeList* const primeList) {
+    Gf2Polynomial maximumPrime     = primeListMaximumPrime(primeList);
+    Gf2Polynomial endBit           = (maximumPrime + 1) >> 1;
+    unsigned      maximumDegree    = gf2Degree(maximumPrime);
+    unsigned long numberMismatches = 0;
+    unsigned      degree;
+
+    advisePrimeList(primeList, PRIME_LIST_ACCESS_SEQUENTIAL);
+
+    printf("degree\tcount\texpected\tstatus\n");
+
+    for (degree=1 ; degree<=maximumDegree ; ++degree) {
+        Gf2Polynomial      bandFirstBit = (Gf2Polynomial) 1 << (degree - 1);
+        Gf2Polynomial      bandEndBit   = (Gf2Polynomial) 1 << degree;
+        unsigned long long count        = degree == 1 ? 1 : 0;
+        unsigned long long expected     = necklaceCount(degree);
+        unsigned long      poolIndex;
+        unsigned long      lastPool;
+        char const*        status;
+
+        /* Only odd values are tracked by the pools so 2 is added to the first band.  When the maximum prime is a power
+         * of two the last band holds no tracked values and is reported as partial without reading any pool. */
+
+        if (bandEndBit > endBit) {
+            bandEndBit = endBit;
+        }
+
+        if (bandFirstBit < bandEndBit) {
+            lastPool = primeListPoolIndex(primeList, 2 * bandEndBit - 1);
+            for (poolIndex=primeListPoolIndex(primeList, 2 * bandFirstBit + 1) ; poolIndex<=lastPool ; ++poolIndex) {
+                Gf2Polynomial poolFirstValue;
+                Gf2Polynomial poolLastValue;
+                Gf2Polynomial poolFirstBit;
+                Gf2Polynomial firstBit;
+                Gf2Polynomial lastBit;
+
+                primeListPoolBounds(primeList, poolIndex, &poolFirstValue, &poolLastValue);
+                poolFirstBit = poolFirstValue >> 1;
+                firstBit     = bandFirstBit > poolFirstBit ? bandFirstBit - poolFirstBit : 0;
+                lastBit      = (bandEndBit - 1 < poolLastValue >> 1 ? bandEndBit - 1 : poolLastValue >> 1)
+                               - poolFirstBit;
+
+                count += lastBit + 1 - firstBit;
+                count -= countOnesInBitRange(primeListPoolWords(primeList, poolIndex), firstBit, lastBit + 1);
+            }
+        }
+
+        if (bandEndBit < (Gf2Polynomial) 1 << degree) {
+            status = "partial";
+        } else if (count == expected) {
+            status = "ok";
+        } else {
+            status = "MISMATCH";
+            ++numberMismatches;
+        }
+
+        printf("%u\t%llu\t%llu\t%s\n", degree, count, expected, status);
+    }
+
+    if (numberMismatches != 0) {
+        fprintf(stderr, "*** Error: %lu degrees do not match the necklace formula.\n", numberMismatches);
+    }
+
+    return numberMismatches == 0 ? 0 : -1;
+}
+
 
 int main(int argumentCount, char** argumentValues) {
-    Gf2Polynomial prime = 2;
+    Gf2Polynomial          prime;
+    PrimeListConfiguration configuration;
+    PrimeList*             primeList;
+    char*                  prefixSwitch;
+    int*                   memoryMapSwitch;
+    long*                  cacheSizeSwitch;
+    char*                  countUpToSwitch;
+    long long*             nthPrimeSwitch;
+    int*                   countByDegreeSwitch;
+    long*                  degreeSwitch;
+    char*                  fromSwitch;
+    char*                  toSwitch;
+    char*                  formatSwitch;
+    long*                  threadsSwitch;
+    unsigned long          numberThreads = NUMBER_LIST_THREADS;
+    PrimeFormat            format     = PRIME_FORMAT_HEX;
+    Gf2Polynomial          countUpTo  = 0;
+    Gf2Polynomial          firstValue = 0;
+    Gf2Polynomial          lastValue  = ~(Gf2Polynomial) 0;
+    long                   exitStatus;
 
-    initializePrimeList(PRIME_FILE_PREFIX, PRIME_FILE_OPEN_FOR_READING);
+    CMDLINE_DEFINITION_START(switches)
+        CMDLINE_STRING("--prefix", prefixSwitch)
+        CMDLINE_BOOL_TRUE("--memory-map", memoryMapSwitch)
+        CMDLINE_LONG("--cache-size", cacheSizeSwitch)
+        CMDLINE_STRING("--count-up-to", countUpToSwitch)
+        CMDLINE_LONG_LONG("--nth-prime", nthPrimeSwitch)
+        CMDLINE_BOOL_TRUE("--count-by-degree", countByDegreeSwitch)
+        CMDLINE_LONG("--degree", degreeSwitch)
+        CMDLINE_STRING("--from", fromSwitch)
+        CMDLINE_STRING("--to", toSwitch)
+        CMDLINE_STRING("--format", formatSwitch)
+        CMDLINE_LONG("--threads", threadsSwitch)
+        CMDLINE_HELP("--help", HELP_TEXT)
+    CMDLINE_DEFINITION_END
 
-    do {
-        printf("%" PRIx64 "\n",prime);
-        prime = findNextPrime(prime);
-    } while (prime != 0);
+    exitStatus = cmdLineParse(&argumentCount, argumentValues, switches);
+    if (exitStatus != 0) {
+        cmdLineReportError(exitStatus, argumentValues, switches);
+        cmdLineDeallocate(switches);
 
-    terminatePrimeList();
+        return cmdLineExitCode(exitStatus) == CMDLINE_HELP_REQUESTED ? 0 : 1;
+    }
 
-    return 0;
+    if (argumentCount > 1) {
+        fprintf(stderr, "*** Error: Unexpected argument \"%s\".\n", argumentValues[1]);
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    if ((countUpToSwitch != NULL && parseValue(countUpToSwitch, &countUpTo) != 0)
+        || (fromSwitch != NULL && parseValue(fromSwitch, &firstValue) != 0)
+        || (toSwitch != NULL && parseValue(toSwitch, &lastValue) != 0)) {
+        cmdLineDeallocate(switches);
+        return 1;
+    }
+
+    if (formatSwitch != NULL && primeFormatFromName(formatSwitch, &format) != 0) {
+        fprintf(stderr, "*** Error: Unknown format \"%s\".\n", formatSwitch);
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    if (threadsSwitch != NULL) {
+        if (*threadsSwitch < 0) {
+            fprintf(stderr, "*** Error: The number of threads can not be negative.\n");
+            cmdLineDeallocate(switches);
+
+            return 1;
+        }
+
+        numberThreads = (unsigned long) *threadsSwitch;
+    }
+
+    if (numberThreads == 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        numberThreads = processors > 0 ? (unsigned long) processors : 1;
+    }
+
+    if (degreeSwitch != NULL) {
+        Gf2Polynomial degreeFirstValue;
+        Gf2Polynomial degreeLastValue;
+
+        if (*degreeSwitch < 0 || *degreeSwitch > 63) {
+            fprintf(stderr, "*** Error: The degree must be between 0 and 63.\n");
+            cmdLineDeallocate(switches);
+
+            return 1;
+        }
+
+        /* The degree is combined with any --from and --to bounds.  The last value wraps correctly for degree 63. */
+
+        degreeFirstValue = (Gf2Polynomial) 1 << *degreeSwitch;
+        degreeLastValue  = 2 * degreeFirstValue - 1;
+
+        if (firstValue < degreeFirstValue) {
+            firstValue = degreeFirstValue;
+        }
+
+        if (lastValue > degreeLastValue) {
+            lastValue = degreeLastValue;
+        }
+    }
+
+    if (nthPrimeSwitch != NULL && *nthPrimeSwitch <= 0) {
+        fprintf(stderr, "*** Error: The prime position must be positive.\n");
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    /* The threads share the pools through a read-only handle that keeps every pool mapped. */
+
+    exitStatus = configurePrimeList(
+        &configuration,
+        NULL,
+        NULL,
+        NULL,
+        prefixSwitch,
+        numberThreads > 1 || (memoryMapSwitch != NULL && *memoryMapSwitch) ? "mapped" : NULL,
+        cacheSizeSwitch
+    );
+
+    if (exitStatus != 0) {
+        cmdLineDeallocate(switches);
+        return 1;
+    }
+
+    primeList = createPrimeList(&configuration, PRIME_FILE_OPEN_FOR_READING);
+    if (primeList == NULL) {
+        cmdLineDeallocate(switches);
+        return 1;
+    }
+
+    if (countUpToSwitch != NULL) {
+        printf("%llu\n", countPrimesUpTo(primeList, countUpTo));
+    }
+
+    if (nthPrimeSwitch != NULL) {
+        prime = nthPrime(primeList, *nthPrimeSwitch);
+        if (prime != 0) {
+            printf("%" PRIx64 "\n", prime);
+        } else {
+            fprintf(stderr, "*** Error: The list holds fewer than %lld primes.\n", *nthPrimeSwitch);
+            exitStatus = 1;
+        }
+    }
+
+    if (countByDegreeSwitch != NULL && countByDegree(primeList) != 0) {
+        exitStatus = 1;
+    }
+
+    if (countUpToSwitch == NULL && nthPrimeSwitch == NULL && countByDegreeSwitch == NULL) {
+        if (listPrimes(primeList, firstValue, lastValue, format, numberThreads) != 0) {
+            exitStatus = 1;
+        }
+    }
+
+    destroyPrimeList(primeList);
+    cmdLineDeallocate(switches);
+
+    return exitStatus == 0 ? 0 : 1;
 }
@@ -31,17 +31,18 @@
 * \brief Indicates the default maximum prime value that will be searched for.
 *
 * You can use this define to specify the maximum prime value that will be assumed unless otherwise specified on the
-* command line.
+* command line using the --maximum-prime switch.
 ***********************************************************************************************************************/
-//#define MAXIMUM_PRIME (0x100000000000ULL)-1
-#define MAXIMUM_PRIME (1ULL << 34)-1
-//#define MAXIMUM_PRIME (0x10000ULL)-1
+//#define MAXIMUM_PRIME ((0x100000000000ULL)-1)
+#define MAXIMUM_PRIME ((1ULL << 34)-1)
+//#define MAXIMUM_PRIME ((0x10000ULL)-1)
 
 /*******************************************************************************************************************//**
 * \brief Indicates the number of primes tracked per puddle.
 *
 * You can use this define to determine the number of primes tracked per puddle.  A puddle represents a single storage
-* element in memory that will be atomically updated.
+* element in memory that will be atomically updated.  The value must be 32 or 64 and can be overridden on the command
+* line using the --puddle-size switch.
 ***********************************************************************************************************************/
 #define PUDDLE_SIZE (32)
 
@@ -49,15 +50,141 @@
 * \brief Indicates the maximum in memory allocation.
 *
 * You can use this define to determine the maximimum memory allocation that this application should assume.  Note that
-* this size is approximate and may be off due to memory alignment constraints.
+* this size is approximate and may be off due to memory alignment constraints.  The value must be a multiple of 8
+* between PRIME_CONTAINER_POOL_ALIGNMENT and PRIME_CONTAINER_MAXIMUM_POOL_SIZE and can be overridden on the command line
+* using the --pool-size switch.
 ***********************************************************************************************************************/
 #define POOL_SIZE_IN_BYTES (1024*1024*1024)
-//#define POOL_SIZE_IN_BYTES (1024)
+//#define POOL_SIZE_IN_BYTES (64*1024)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the default memory budget for the pools held in memory.
+*
+* You can use this define to specify how much memory the prime list may use to hold pools.  Automatic storage holds a
+* list that is being built entirely in memory when every pool fits in the budget.  Otherwise the budget limits the
+* number of sieve threads, each of which holds up to three pools, and the remainder sizes the pool cache, which keeps
+* recently used pools resident.  Accesses that alternate between a few pools, such as marking a value
+* in one pool and then searching for the next prime in another, only reload a pool when it falls out of the cache.  At
+* least one pool is always cached.  The value can be overridden on the command line using the --cache-size switch.
+***********************************************************************************************************************/
+#define POOL_CACHE_SIZE_IN_BYTES (POOL_SIZE_IN_BYTES)
+
+/*******************************************************************************************************************//**
+* \brief Indicates where the pools of the prime list are held by default.
+*
+* You can use this define to select how the prime list reaches its pools.  PRIME_LIST_STORAGE_MEMORY holds every pool in
+* memory and writes the pools to the container once, when the list is flushed.  PRIME_LIST_STORAGE_POOLED reads a whole
+* pool into the pool cache on first access and writes back the pages of the pool that changed.
+* PRIME_LIST_STORAGE_MAPPED memory maps each pool so only the pages that are touched are read and only the pages that
+* are modified are written back.  PRIME_LIST_STORAGE_AUTOMATIC selects memory storage when a list that is created or
+* updated fits in POOL_CACHE_SIZE_IN_BYTES and mapped storage otherwise, falling back to pooled storage for lists with
+* too many pools to map.  A run held in memory does not checkpoint its progress.  The default can be overridden on the
+* command line using the --storage switch.
+***********************************************************************************************************************/
+#define PRIME_LIST_STORAGE (PRIME_LIST_STORAGE_AUTOMATIC)
+
+/*******************************************************************************************************************//**
+* \brief Indicates whether the sieve should be segmented by pool.
+*
+* You can use this define to select how the sieve walks the prime list.  When non-zero, the sieve completes one pool at
+* a time by applying every sieving prime to the resident pool before moving on so each pool is read and written once.
+* When zero, each prime is applied across every pool before the next prime is applied.
+***********************************************************************************************************************/
+#define SEGMENTED_SIEVE (1)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the number of threads used by the segmented sieve.
+*
+* You can use this define to specify how many worker threads the segmented sieve should use.  Each worker owns a
+* contiguous range of pools.  A worker sieves one pool while the next pool is read and the previous pool is written
+* back, so memory use grows by up to three times POOL_SIZE_IN_BYTES per thread.  A value of 0 selects one thread per
+* online processor.  The value can be overridden on the command line using the --threads switch.
+***********************************************************************************************************************/
+#define NUMBER_SIEVE_THREADS (0)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the size of a sieve segment.
+*
+* You can use this define to specify the size of the cache-sized segments used by the bucket sieve.  Sieving primes
+* whose degree is at least the base 2 log of the number of values spanned by a segment land at most one mark per
+* segment.  Those primes are held in per-segment buckets and applied one segment at a time rather than one prime at a
+* time.  The value should be a power of 2 close to the size of the processor's L1 or L2 data cache.
+***********************************************************************************************************************/
+#define SIEVE_SEGMENT_SIZE_IN_BYTES (32*1024)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the largest degree of the sieving primes handled by the pre-sieve.
+*
+* You can use this define to specify which of the smallest sieving primes are removed by stamping precomputed patterns
+* into each pool instead of marking each multiple.  The primes are packed into groups whose product has a degree of at
+* most 16 and every group costs one OR per 16 bytes of pool and 1 MByte of patterns.  Raising the value past the
+* point where a group holds only one or two primes costs more than it saves.  A value of 0 disables the pre-sieve.
+***********************************************************************************************************************/
+#define PRESIEVE_MAXIMUM_DEGREE (6)
+
+/*******************************************************************************************************************//**
+* \brief Indicates how often the prime ordered sieve writes a checkpoint.
+*
+* You can use this define to specify the minimum number of seconds between checkpoints when SEGMENTED_SIEVE is 0.  Each
+* checkpoint flushes the resident pool.  The segmented sieve updates its checkpoint every time a pool is written back
+* and ignores this value.
+***********************************************************************************************************************/
+#define CHECKPOINT_INTERVAL_IN_SECONDS (600)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the size of the buffer used to write the prime list.
+*
+* You can use this define to specify how much formatted output list_primes_gf2 accumulates before handing it to the
+* kernel in a single write call.  Larger values reduce the number of system calls.
+***********************************************************************************************************************/
+#define OUTPUT_BUFFER_SIZE_IN_BYTES (4*1024*1024)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the number of threads used to list the primes.
+*
+* You can use this define to specify how many worker threads list_primes_gf2 uses by default.  Each worker formats a
+* chunk of the list into its own buffer and the chunks are written in order.  Using more than one thread memory maps
+* the pools.  A value of 0 selects one thread per online processor.
+***********************************************************************************************************************/
+#define NUMBER_LIST_THREADS (1)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the amount of pool data handled by a listing thread at a time.
+*
+* You can use this define to specify the size of the chunks handed to the listing threads.  Larger chunks reduce the
+* synchronization between threads while smaller chunks spread short ranges across more threads.
+***********************************************************************************************************************/
+#define LIST_CHUNK_SIZE_IN_BYTES (256*1024)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the Unix domain socket used by the query server.
+*
+* You can use this define to specify where prime_server_gf2 listens and where its clients connect.  The path can be
+* overridden on the command line using the --socket switch.
+***********************************************************************************************************************/
+#define QUERY_SOCKET_PATH ("primes.socket")
+
+/*******************************************************************************************************************//**
+* \brief Indicates the number of requests the query server reads at a time.
+*
+* You can use this define to specify how many pipelined requests prime_server_gf2 answers per read and write call on
+* each connection.  Larger values reduce the number of system calls under heavy load.
+***********************************************************************************************************************/
+#define QUERY_BATCH_SIZE (4096)
+
+/*******************************************************************************************************************//**
+* \brief Indicates how often the query server reports its counters.
+*
+* You can use this define to specify the number of seconds between the throughput and latency reports written by
+* prime_server_gf2.  A value of 0 only reports the counters when the server stops.
+***********************************************************************************************************************/
+#define QUERY_REPORT_INTERVAL_IN_SECONDS (60)
 
 /*******************************************************************************************************************//**
 * \brief Indicates the file prefix to use for the prime files.
 *
-* You can use this define to specify the prefix for files containing information on the primes.
+* You can use this define to specify the prefix for files containing information on the primes.  The prefix can be
+* overridden on the command line using the --prefix switch.
 ***********************************************************************************************************************/
 #define PRIME_FILE_PREFIX ("primes.")
 
@@ -0,0 +1,172 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Counts set bits in large arrays.
+*
+* This file implements the bulk bit counting used to check prime lists.
+***********************************************************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "compiler.h"
+#include "popcount.h"
+
+
+#if (defined(TARGET_VECTOR_POPCOUNT))
+
+    #include <immintrin.h>
+
+#endif
+
+
+typedef uint64_t (*CountFunction)(uint64_t const* const, uint64_t const);
+
+
+static uint64_t countOnesScalar(uint64_t const* const words, uint64_t const numberWords) {
+    uint64_t result = 0;
+    uint64_t i;
+
+    for (i=0 ; i<numberWords ; ++i) {
+        result += countOnes64(words[i]);
+    }
+
+    return result;
+}
+
+
+#if (defined(TARGET_VECTOR_POPCOUNT))
+
+    TARGET_VECTOR_POPCOUNT static uint64_t countOnesVector(uint64_t const* const words, uint64_t const numberWords) {
+        __m256i const lookup = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+        );
+        __m256i const lowNibbles   = _mm256_set1_epi8(0x0F);
+        __m256i       total        = _mm256_setzero_si256();
+        uint64_t      numberBlocks = numberWords / 4;
+        uint64_t      block        = 0;
+        uint64_t      result;
+
+        /* Each byte of the accumulator counts at most 8 bits per step so it is folded into the 64-bit totals every 31
+         * steps, before any byte can overflow. */
+
+        while (block < numberBlocks) {
+            uint64_t endBlock    = numberBlocks - block > 31 ? block + 31 : numberBlocks;
+            __m256i  accumulator = _mm256_setzero_si256();
+
+            for ( ; block<endBlock ; ++block) {
+                __m256i v    = _mm256_loadu_si256((__m256i const*) (words + 4 * block));
+                __m256i low  = _mm256_and_si256(v, lowNibbles);
+                __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibbles);
+
+                accumulator = _mm256_add_epi8(accumulator, _mm256_shuffle_epi8(lookup, low));
+                accumulator = _mm256_add_epi8(accumulator, _mm256_shuffle_epi8(lookup, high));
+            }
+
+            total = _mm256_add_epi64(total, _mm256_sad_epu8(accumulator, _mm256_setzero_si256()));
+        }
+
+        result = (uint64_t) _mm256_extract_epi64(total, 0)
+                 + (uint64_t) _mm256_extract_epi64(total, 1)
+                 + (uint64_t) _mm256_extract_epi64(total, 2)
+                 + (uint64_t) _mm256_extract_epi64(total, 3);
+
+        return result + countOnesScalar(words + 4 * numberBlocks, numberWords - 4 * numberBlocks);
+    }
+
+#endif
+
+
+static uint64_t countSelect(uint64_t const* const words, uint64_t const numberWords);
+
+/* The implementation is selected once, on first use, under countOnce.  Threads that still see countSelect wait for
+ * the selection inside pthread_once so the name is only read once it has been written. */
+
+static pthread_once_t         countOnce     = PTHREAD_ONCE_INIT;
+static _Atomic(CountFunction) countFunction = &countSelect;
+static char const*            countName     = NULL;
+
+
+static void selectCountFunction(void) {
+    CountFunction function;
+
+    #if (defined(TARGET_VECTOR_POPCOUNT))
+
+        if (cpuSupportsVectorPopcount()) {
+            countName = "avx2";
+            function  = &countOnesVector;
+        } else {
+            countName = "scalar";
+            function  = &countOnesScalar;
+        }
+
+    #else
+
+        countName = "scalar";
+        function  = &countOnesScalar;
+
+    #endif
+
+    atomic_store_explicit(&countFunction, function, memory_order_release);
+}
+
+
+INLINE CountFunction currentCountFunction(void) {
+    return atomic_load_explicit(&countFunction, memory_order_relaxed);
+}
+
+
+static uint64_t countSelect(uint64_t const* const words, uint64_t const numberWords) {
+    pthread_once(&countOnce, &selectCountFunction);
+    return (*currentCountFunction())(words, numberWords);
+}
+
+
+uint64_t countOnesInBitRange(uint64_t const* const words, uint64_t const firstBit, uint64_t const endBit) {
+    uint64_t firstWord = firstBit / 64;
+    uint64_t endWord   = endBit / 64;
+    uint64_t result;
+
+    if (firstBit >= endBit) {
+        result = 0;
+    } else if (firstWord == endWord) {
+        result = countOnes64((words[firstWord] >> (firstBit % 64)) & (((uint64_t) 1 << (endBit - firstBit)) - 1));
+    } else {
+        result = 0;
+
+        /* The partial words at either end are masked and the whole words in between are counted in bulk. */
+
+        if (firstBit % 64 != 0) {
+            result += countOnes64(words[firstWord] >> (firstBit % 64));
+            ++firstWord;
+        }
+
+        if (endBit % 64 != 0) {
+            result += countOnes64(words[endWord] & (((uint64_t) 1 << (endBit % 64)) - 1));
+        }
+
+        result += (*currentCountFunction())(words + firstWord, endWord - firstWord);
+    }
+
+    return result;
+}
+
+
+char const* popcountMethod(void) {
+    pthread_once(&countOnce, &selectCountFunction);
+    return countName;
+}
@@ -0,0 +1,52 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Counts set bits in large arrays.
+*
+* This file defines functions used to count the set bits in large bitmaps, such as the pools of a prime list, at close
+* to memory bandwidth.  Processors with AVX2 count 256 bits per step using a nibble lookup table.  Other processors
+* count one 64-bit word at a time.
+***********************************************************************************************************************/
+
+#ifndef POPCOUNT_H
+#define POPCOUNT_H
+
+#include <stdint.h>
+
+#include "compiler.h"
+
+/*******************************************************************************************************************//**
+* \brief Counts the set bits in a range of bits.
+*
+* You can use this function to count the set bits between two bit positions of an array of 64-bit words.  Bit i of the
+* array is bit i % 64 of word i / 64.
+*
+* \param[in] words    The array holding the bits.
+*
+* \param[in] firstBit The first bit to count.
+*
+* \param[in] endBit   One past the last bit to count.
+*
+* \return Returns the number of set bits in the range.
+***********************************************************************************************************************/
+GF2PRIMES_API uint64_t countOnesInBitRange(uint64_t const* const words, uint64_t const firstBit, uint64_t const endBit);
+
+/*******************************************************************************************************************//**
+* \brief Reports which method is used to count bits.
+*
+* \return Returns a short description of the method, for example "avx2".
+***********************************************************************************************************************/
+GF2PRIMES_API char const* popcountMethod(void);
+
+#endif
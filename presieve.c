@@ -0,0 +1,308 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Pre-sieve used to apply the smallest sieving primes.
+*
+* This file implements the pre-sieve used to stamp out the multiples of the smallest sieving primes.
+***********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#if (defined(__SSE2__))
+
+    #include <emmintrin.h>
+
+#endif
+
+#include "compiler.h"
+#include "gf2.h"
+#include "prime_list.h"
+#include "sieving_primes.h"
+#include "presieve.h"
+
+
+#define PRESIEVE_BLOCK_SIZE_LOG2 (16)
+#define PRESIEVE_BLOCK_VALUES ((Gf2Polynomial) 1 << PRESIEVE_BLOCK_SIZE_LOG2)
+#define PRESIEVE_BLOCK_BITS (PRESIEVE_BLOCK_VALUES / 2)
+#define PRESIEVE_BLOCK_WORDS (PRESIEVE_BLOCK_BITS / 64)
+#define PRESIEVE_CHUNK_SIZE_LOG2 (8)
+#define PRESIEVE_CHUNK_BITS (1 << (PRESIEVE_CHUNK_SIZE_LOG2 - 1))
+#define PRESIEVE_CHUNK_WORDS (PRESIEVE_CHUNK_BITS / 64)
+#define PRESIEVE_NUMBER_CHUNKS (PRESIEVE_BLOCK_BITS / PRESIEVE_CHUNK_BITS)
+#define PRESIEVE_NUMBER_VARIANTS (1 << PRESIEVE_CHUNK_SIZE_LOG2)
+#define PRESIEVE_NUMBER_STEPS (64 - PRESIEVE_BLOCK_SIZE_LOG2)
+
+
+typedef struct PresieveGroup {
+    uint64_t*     patterns;
+    Gf2Polynomial product;
+    unsigned      degree;
+    Gf2Polynomial steps[PRESIEVE_NUMBER_STEPS];
+} PresieveGroup;
+
+
+struct Presieve {
+    PresieveGroup*  groups;
+    unsigned long   numberGroups;
+    uint32_t const* primes;
+    unsigned long   numberPrimes;
+};
+
+
+static void buildPatterns(
+        PresieveGroup* const       group,
+        uint32_t const* const      primes,
+        unsigned long const* const groupOf,
+        unsigned long const        numberPrimes,
+        unsigned long const        groupIndex
+    ) {
+    uint64_t      base[PRESIEVE_BLOCK_VALUES / 64];
+    unsigned long i;
+    unsigned      variant;
+
+    /* Bit r of the base pattern is cleared when r is a multiple of any prime in the group.  Unlike the pool, the base
+     * pattern tracks both even and odd values since XOR translation by an odd remainder swaps the two. */
+
+    memset(base, 0xFF, sizeof(base));
+    base[0] &= ~(uint64_t) 1;
+
+    for (i=0 ; i<numberPrimes ; ++i) {
+        if (groupOf[i] == groupIndex) {
+            Gf2MultipleIterator multiples;
+            Gf2Polynomial       multiple;
+
+            gf2MultiplesStart(&multiples, primes[i], 0, PRESIEVE_BLOCK_VALUES - 1, 0);
+            while ((multiple = gf2MultiplesNext(&multiples)) != 0) {
+                base[multiple / 64] &= ~((uint64_t) 1 << (multiple % 64));
+            }
+        }
+    }
+
+    /* Variant v holds the pool bits for a block whose remainder has v as its low bits.  Like the pool, a set bit in a
+     * variant marks a composite.  The remaining bits of the remainder select which chunk of the variant is applied,
+     * see applyPresieve. */
+
+    group->patterns = malloc(PRESIEVE_NUMBER_VARIANTS * PRESIEVE_BLOCK_WORDS * sizeof(uint64_t));
+    assert(group->patterns != NULL);
+
+    for (variant=0 ; variant<PRESIEVE_NUMBER_VARIANTS ; ++variant) {
+        uint64_t*     pattern = group->patterns + variant * PRESIEVE_BLOCK_WORDS;
+        unsigned long bit;
+
+        memset(pattern, 0, PRESIEVE_BLOCK_WORDS * sizeof(uint64_t));
+
+        for (bit=0 ; bit<PRESIEVE_BLOCK_BITS ; ++bit) {
+            Gf2Polynomial r = (2 * bit + 1) ^ variant;
+            if (((base[r / 64] >> (r % 64)) & 1) == 0) {
+                pattern[bit / 64] |= (uint64_t) 1 << (bit % 64);
+            }
+        }
+    }
+
+    /* Advancing the block index from H to H+1 flips the t+1 low bits of H where t is the number of trailing ones.  By
+     * linearity the remainder changes by the sum of x^(k+j) mod P for j <= t. */
+
+    for (i=0 ; i<PRESIEVE_NUMBER_STEPS ; ++i) {
+        Gf2Polynomial term = gf2Remainder((Gf2Polynomial) 1 << (PRESIEVE_BLOCK_SIZE_LOG2 + i), group->product);
+        group->steps[i] = i == 0 ? term : group->steps[i - 1] ^ term;
+    }
+}
+
+
+static void stampBlock(
+        uint64_t* const              words,
+        uint64_t const* const* const patterns,
+        unsigned const* const        offsets,
+        unsigned long const          numberGroups
+    ) {
+    unsigned chunk;
+
+    for (chunk=0 ; chunk<PRESIEVE_NUMBER_CHUNKS ; ++chunk) {
+        uint64_t*     destination = words + chunk * PRESIEVE_CHUNK_WORDS;
+        unsigned long g;
+
+        #if (defined(__SSE2__))
+
+            __m128i accumulator = _mm_loadu_si128((__m128i const*) destination);
+
+            for (g=0 ; g<numberGroups ; ++g) {
+                uint64_t const* source = patterns[g] + (chunk ^ offsets[g]) * PRESIEVE_CHUNK_WORDS;
+                accumulator = _mm_or_si128(accumulator, _mm_loadu_si128((__m128i const*) source));
+            }
+
+            _mm_storeu_si128((__m128i*) destination, accumulator);
+
+        #else
+
+            for (g=0 ; g<numberGroups ; ++g) {
+                uint64_t const* source = patterns[g] + (chunk ^ offsets[g]) * PRESIEVE_CHUNK_WORDS;
+                unsigned        j;
+
+                for (j=0 ; j<PRESIEVE_CHUNK_WORDS ; ++j) {
+                    destination[j] |= source[j];
+                }
+            }
+
+        #endif
+    }
+}
+
+
+Presieve* createPresieve(SievingPrimes const* const sievingPrimes, unsigned const maximumDegree) {
+    Presieve*      presieve = malloc(sizeof(Presieve));
+    unsigned long* groupOf;
+    unsigned long  i;
+
+    assert(presieve != NULL);
+    assert(maximumDegree <= PRESIEVE_BLOCK_SIZE_LOG2);
+
+    presieve->primes       = sievingPrimes->primes;
+    presieve->numberPrimes = firstSievingPrimeOfDegree(sievingPrimes, maximumDegree + 1);
+    presieve->numberGroups = 0;
+    presieve->groups       = malloc((presieve->numberPrimes + 1) * sizeof(PresieveGroup));
+    assert(presieve->groups != NULL);
+
+    groupOf = malloc((presieve->numberPrimes + 1) * sizeof(unsigned long));
+    assert(groupOf != NULL);
+
+    /* Pack the primes, largest first, into the first group whose product stays within the block size. */
+
+    for (i=presieve->numberPrimes ; i>0 ; --i) {
+        Gf2Polynomial  prime  = presieve->primes[i - 1];
+        unsigned       degree = gf2Degree(prime);
+        unsigned long  g      = 0;
+        PresieveGroup* group;
+
+        while (g < presieve->numberGroups && presieve->groups[g].degree + degree > PRESIEVE_BLOCK_SIZE_LOG2) {
+            ++g;
+        }
+
+        group = presieve->groups + g;
+        if (g == presieve->numberGroups) {
+            group->product = 1;
+            group->degree  = 0;
+            ++presieve->numberGroups;
+        }
+
+        group->product  = gf2Multiply(group->product, prime);
+        group->degree  += degree;
+        groupOf[i - 1]  = g;
+    }
+
+    for (i=0 ; i<presieve->numberGroups ; ++i) {
+        buildPatterns(presieve->groups + i, presieve->primes, groupOf, presieve->numberPrimes, i);
+    }
+
+    free(groupOf);
+
+    return presieve;
+}
+
+
+unsigned long presieveNumberPrimes(Presieve const* const presieve) {
+    return presieve->numberPrimes;
+}
+
+
+void applyPresieve(Presieve const* const presieve, PoolBuffer* const poolBuffer) {
+    unsigned long        numberGroups = presieve->numberGroups;
+    uint64_t*            words;
+    uint64_t const**     patterns;
+    unsigned*            offsets;
+    Gf2Polynomial*       remainders;
+    Gf2Polynomial        firstValue;
+    Gf2Polynomial        lastValue;
+    Gf2Polynomial        blockIndex;
+    Gf2Polynomial        endBlockIndex;
+    unsigned long        g;
+    unsigned long        i;
+
+    if (numberGroups == 0) {
+        return;
+    }
+
+    /* Pools that do not hold a whole number of aligned blocks, such as a pool trimmed by the maximum prime, fall back
+     * to marking each multiple. */
+
+    poolBufferBounds(poolBuffer, &firstValue, &lastValue);
+    if (firstValue % PRESIEVE_BLOCK_VALUES != 0 || (lastValue + 1) % PRESIEVE_BLOCK_VALUES != 0) {
+        for (i=0 ; i<presieve->numberPrimes ; ++i) {
+            markMultiplesInPoolBuffer(poolBuffer, presieve->primes[i]);
+        }
+
+        return;
+    }
+
+    words      = poolBufferWords(poolBuffer);
+    patterns   = malloc(numberGroups * sizeof(uint64_t const*));
+    offsets    = malloc(numberGroups * sizeof(unsigned));
+    remainders = malloc(numberGroups * sizeof(Gf2Polynomial));
+    assert(patterns != NULL && offsets != NULL && remainders != NULL);
+
+    for (g=0 ; g<numberGroups ; ++g) {
+        remainders[g] = gf2Remainder(firstValue, presieve->groups[g].product);
+    }
+
+    blockIndex    = firstValue >> PRESIEVE_BLOCK_SIZE_LOG2;
+    endBlockIndex = (lastValue >> PRESIEVE_BLOCK_SIZE_LOG2) + 1;
+    while (blockIndex < endBlockIndex) {
+        unsigned t = countTrailingZeros64(~blockIndex);
+
+        for (g=0 ; g<numberGroups ; ++g) {
+            PresieveGroup const* group = presieve->groups + g;
+
+            patterns[g] = group->patterns + (remainders[g] % PRESIEVE_NUMBER_VARIANTS) * PRESIEVE_BLOCK_WORDS;
+            offsets[g]  = (unsigned) (remainders[g] / PRESIEVE_NUMBER_VARIANTS);
+
+            remainders[g] ^= group->steps[t];
+        }
+
+        stampBlock(words, patterns, offsets, numberGroups);
+
+        words += PRESIEVE_BLOCK_WORDS;
+        ++blockIndex;
+    }
+
+    free(remainders);
+    free(offsets);
+    free(patterns);
+
+    /* The stamps also clear the pre-sieve primes themselves. */
+
+    words = poolBufferWords(poolBuffer);
+    for (i=0 ; i<presieve->numberPrimes ; ++i) {
+        Gf2Polynomial prime = presieve->primes[i];
+
+        if (prime >= firstValue && prime <= lastValue) {
+            Gf2Polynomial bit = (prime - firstValue) >> 1;
+            words[bit / 64] &= ~((uint64_t) 1 << (bit % 64));
+        }
+    }
+}
+
+
+void destroyPresieve(Presieve* const presieve) {
+    unsigned long i;
+
+    for (i=0 ; i<presieve->numberGroups ; ++i) {
+        free(presieve->groups[i].patterns);
+    }
+
+    free(presieve->groups);
+    free(presieve);
+}
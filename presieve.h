@@ -0,0 +1,84 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Pre-sieve used to apply the smallest sieving primes.
+*
+* This file defines functions used to remove the multiples of the smallest sieving primes by stamping precomputed
+* patterns into a pool rather than marking each multiple.  The small primes are gathered into groups whose product P
+* has a degree no larger than the pre-sieve block size.  For a value v = H * x^k + r, the remainder of v modulo P is
+* the remainder of c ^ r where c is the remainder of H * x^k.  Every aligned block of x^k values is therefore an XOR
+* translate, or coset, of a single pattern built once per group.
+***********************************************************************************************************************/
+
+#ifndef PRESIEVE_H
+#define PRESIEVE_H
+
+#include "gf2.h"
+#include "prime_list.h"
+#include "sieving_primes.h"
+
+/*******************************************************************************************************************//**
+* \brief Opaque pre-sieve state.
+*
+* You can use this type to hold the patterns used to stamp out the multiples of the smallest sieving primes.  The
+* pre-sieve is not modified once created and can be shared between threads.
+***********************************************************************************************************************/
+typedef struct Presieve Presieve;
+
+/*******************************************************************************************************************//**
+* \brief Creates a pre-sieve.
+*
+* You can use this function to build the stamping patterns for every sieving prime whose degree does not exceed
+* maximumDegree.  Each group of primes needs 1 MByte of patterns.
+*
+* \param[in] sievingPrimes The table of sieving primes.
+*
+* \param[in] maximumDegree The largest degree of the sieving primes to be handled by the pre-sieve.  A value of 0
+*                          disables the pre-sieve.
+*
+* \return Returns a newly allocated pre-sieve.
+***********************************************************************************************************************/
+Presieve* createPresieve(SievingPrimes const* const sievingPrimes, unsigned const maximumDegree);
+
+/*******************************************************************************************************************//**
+* \brief Determines the number of sieving primes handled by a pre-sieve.
+*
+* You can use this function to determine where sieving should resume after the pre-sieve has been applied.
+*
+* \param[in] presieve The pre-sieve to query.
+*
+* \return Returns the number of leading sieving primes handled by the pre-sieve.
+***********************************************************************************************************************/
+unsigned long presieveNumberPrimes(Presieve const* const presieve);
+
+/*******************************************************************************************************************//**
+* \brief Applies a pre-sieve to a pool.
+*
+* You can use this function to mark every multiple of the pre-sieve's primes inside the pool currently held by a pool
+* buffer.  The primes themselves are left unmarked.
+*
+* \param[in]     presieve   The pre-sieve to apply.
+*
+* \param[in,out] poolBuffer The pool buffer to update.  A pool must be loaded.
+***********************************************************************************************************************/
+void applyPresieve(Presieve const* const presieve, PoolBuffer* const poolBuffer);
+
+/*******************************************************************************************************************//**
+* \brief Releases a pre-sieve.
+*
+* \param[in] presieve The pre-sieve to be released.
+***********************************************************************************************************************/
+void destroyPresieve(Presieve* const presieve);
+
+#endif
@@ -0,0 +1,440 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Generates load against prime_server_gf2.
+*
+* This program benchmarks prime_server_gf2.  Each connection is driven by its own thread, which sends batches of random
+* queries and keeps a fixed number of batches in flight.  The round trip latency of each batch and the overall
+* throughput are reported when every request has been answered.
+***********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <unistd.h>
+#include <pthread.h>
+
+#include "compiler.h"
+#include "gf2.h"
+#include "prime_query.h"
+#include "cmdline.h"
+
+#include "parameters.h"
+
+
+/*******************************************************************************************************************//**
+* \brief Indicates the program version.
+*
+* You can use this define to specify the program version.
+***********************************************************************************************************************/
+#define VERSION ("1.0")
+
+/*******************************************************************************************************************//**
+* \brief Indicates the largest number of requests a connection may have in flight.
+*
+* You can use this define to bound the data queued on a connection.  Both directions must fit in the socket buffers,
+* otherwise the client and the server can each block writing to the other.
+***********************************************************************************************************************/
+#define MAXIMUM_REQUESTS_IN_FLIGHT (8192)
+
+/*******************************************************************************************************************//**
+* \brief Indicates the help text displayed by the --help switch.
+*
+* You can use this define to describe the switches supported by this program.
+***********************************************************************************************************************/
+#define HELP_TEXT \
+    "Usage: prime_client_gf2 [switches]\n" \
+    "\n" \
+    "Switches:\n" \
+    "    --socket <path>            Path of the server's Unix domain socket.\n" \
+    "    --operation <operation>    Query to send: is-prime, next-prime, rank, nth, or mixed.  The default is\n" \
+    "                               mixed.\n" \
+    "    --requests <count>         Number of requests sent over each connection.  The default is 1000000.\n" \
+    "    --connections <count>      Number of concurrent connections.  The default is 1.\n" \
+    "    --batch-size <count>       Number of requests sent with each write.  The default is 64.\n" \
+    "    --pipeline-depth <count>   Number of batches sent before waiting for a response.  The default is 4.\n" \
+    "    --seed <value>             Seed for the random arguments.\n" \
+    "    --help                     Display this text."
+
+
+/*******************************************************************************************************************//**
+* \brief Settings and results of one load generating connection.
+***********************************************************************************************************************/
+typedef struct LoadGenerator {
+    char const*        socketPath;
+    int                operation;
+    unsigned long      numberRequests;
+    unsigned long      batchSize;
+    unsigned long      pipelineDepth;
+    Gf2Polynomial      maximumPrime;
+    uint64_t           numberPrimes;
+    uint64_t           randomState;
+    QueryStatistics    statistics;
+    unsigned long long numberOutOfRange;
+    int                failed;
+} LoadGenerator;
+
+
+/*******************************************************************************************************************//**
+* \brief Returns the next value of a xorshift64* generator.
+*
+* \param[in,out] state The generator state.  The value must not be 0.
+*
+* \return Returns a pseudo-random 64-bit value.
+***********************************************************************************************************************/
+static uint64_t nextRandom(uint64_t* const state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Fills a request with a random query.
+*
+* \param[in,out] generator The load generator supplying the operation, the bounds, and the random state.
+*
+* \param[out]    request   The request to populate.
+*
+* \param[in]     tag       The tag to assign.
+***********************************************************************************************************************/
+static void randomRequest(LoadGenerator* const generator, PrimeQueryRequest* const request, uint32_t const tag) {
+    uint64_t random    = nextRandom(&generator->randomState);
+    int      operation = generator->operation;
+
+    if (operation == 0) {
+        operation = PRIME_QUERY_IS_PRIME + (int) (random % 4);
+        random    = nextRandom(&generator->randomState);
+    }
+
+    request->tag       = tag;
+    request->operation = operation;
+
+    if (operation == PRIME_QUERY_NTH) {
+        request->argument = 1 + random % generator->numberPrimes;
+    } else {
+        request->argument = generator->maximumPrime == ~(Gf2Polynomial) 0
+                          ? random
+                          : random % (generator->maximumPrime + 1);
+    }
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Sends a single query and waits for the answer.
+*
+* \param[in]  fileDescriptor The connected socket.
+*
+* \param[in]  operation      The query to send.
+*
+* \param[in]  argument       The argument of the query.
+*
+* \param[out] result         The result of the query.
+*
+* \return Returns 0 on success.  Returns -1 if the query failed.
+***********************************************************************************************************************/
+static int query(int const fileDescriptor, int const operation, uint64_t const argument, uint64_t* const result) {
+    PrimeQueryRequest  request;
+    PrimeQueryResponse response;
+
+    request.tag       = 0;
+    request.operation = operation;
+    request.argument  = argument;
+
+    if (sendQueryBytes(fileDescriptor, &request, sizeof(request)) != 0
+        || receiveQueryBytes(fileDescriptor, &response, sizeof(response)) != 0
+        || response.status != PRIME_QUERY_OK) {
+        fprintf(stderr, "*** Error: The server did not answer a query.\n");
+        return -1;
+    }
+
+    *result = response.result;
+
+    return 0;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Thread driving a single connection.
+*
+* You can use this function to send the generator's requests.  Up to the pipeline depth of batches are in flight at any
+* time.  Each batch is timed from the start of its write to the arrival of its last response.
+*
+* \param[in] argument Pointer to the thread's \ref LoadGenerator instance.
+*
+* \return Returns NULL.
+***********************************************************************************************************************/
+static void* loadGeneratorThread(void* argument) {
+    LoadGenerator*      generator     = (LoadGenerator*) argument;
+    unsigned long       batchSize     = generator->batchSize;
+    unsigned long       pipelineDepth = generator->pipelineDepth;
+    unsigned long       numberBatches = (generator->numberRequests + batchSize - 1) / batchSize;
+    PrimeQueryRequest*  requests      = malloc(batchSize * sizeof(PrimeQueryRequest));
+    PrimeQueryResponse* responses     = malloc(batchSize * sizeof(PrimeQueryResponse));
+    unsigned long long* sendTimes     = malloc(pipelineDepth * sizeof(unsigned long long));
+    unsigned long       batchesSent   = 0;
+    unsigned long       batchesDone   = 0;
+    uint32_t            nextTag       = 0;
+    uint32_t            expectedTag   = 0;
+    int                 fileDescriptor;
+
+    assert(requests != NULL && responses != NULL && sendTimes != NULL);
+
+    fileDescriptor = connectToPrimeServer(generator->socketPath);
+    generator->failed = fileDescriptor < 0;
+
+    while (!generator->failed && batchesDone < numberBatches) {
+        unsigned long numberInBatch;
+        unsigned long i;
+
+        while (!generator->failed && batchesSent < numberBatches && batchesSent - batchesDone < pipelineDepth) {
+            numberInBatch = batchesSent == numberBatches - 1
+                          ? generator->numberRequests - batchesSent * batchSize
+                          : batchSize;
+
+            for (i=0 ; i<numberInBatch ; ++i) {
+                randomRequest(generator, requests + i, nextTag++);
+            }
+
+            sendTimes[batchesSent % pipelineDepth] = monotonicNanoseconds();
+            if (sendQueryBytes(fileDescriptor, requests, numberInBatch * sizeof(PrimeQueryRequest)) != 0) {
+                fprintf(stderr, "*** Error: Could not send requests to the server.\n");
+                generator->failed = 1;
+            }
+
+            ++batchesSent;
+        }
+
+        if (!generator->failed) {
+            numberInBatch = batchesDone == numberBatches - 1
+                          ? generator->numberRequests - batchesDone * batchSize
+                          : batchSize;
+
+            if (receiveQueryBytes(fileDescriptor, responses, numberInBatch * sizeof(PrimeQueryResponse)) != 0) {
+                fprintf(stderr, "*** Error: The server closed the connection.\n");
+                generator->failed = 1;
+            } else {
+                recordQueryLatency(
+                    &generator->statistics,
+                    numberInBatch,
+                    monotonicNanoseconds() - sendTimes[batchesDone % pipelineDepth]
+                );
+
+                for (i=0 ; i<numberInBatch && !generator->failed ; ++i) {
+                    if (responses[i].tag != expectedTag++ || responses[i].status == PRIME_QUERY_UNKNOWN_OPERATION) {
+                        fprintf(stderr, "*** Error: Unexpected response from the server.\n");
+                        generator->failed = 1;
+                    } else if (responses[i].status == PRIME_QUERY_OUT_OF_RANGE) {
+                        ++generator->numberOutOfRange;
+                    }
+                }
+
+                ++batchesDone;
+            }
+        }
+    }
+
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+
+    free(requests);
+    free(responses);
+    free(sendTimes);
+
+    return NULL;
+}
+
+
+int main(int argumentCount, char** argumentValues) {
+    char*              socketSwitch;
+    char*              operationSwitch;
+    long*              requestsSwitch;
+    long*              connectionsSwitch;
+    long*              batchSizeSwitch;
+    long*              pipelineDepthSwitch;
+    long long*         seedSwitch;
+    char const*        socketPath        = QUERY_SOCKET_PATH;
+    int                operation         = 0;
+    unsigned long      numberRequests    = 1000000;
+    unsigned long      numberConnections = 1;
+    unsigned long      batchSize         = 64;
+    unsigned long      pipelineDepth     = 4;
+    uint64_t           seed              = 1;
+    Gf2Polynomial      maximumPrime;
+    uint64_t           numberPrimes;
+    LoadGenerator*     generators;
+    pthread_t*         threads;
+    QueryStatistics    statistics;
+    unsigned long long numberOutOfRange  = 0;
+    unsigned long long startTime;
+    unsigned long      i;
+    int                fileDescriptor;
+    long               exitStatus;
+
+    CMDLINE_DEFINITION_START(switches)
+        CMDLINE_STRING("--socket", socketSwitch)
+        CMDLINE_STRING("--operation", operationSwitch)
+        CMDLINE_LONG("--requests", requestsSwitch)
+        CMDLINE_LONG("--connections", connectionsSwitch)
+        CMDLINE_LONG("--batch-size", batchSizeSwitch)
+        CMDLINE_LONG("--pipeline-depth", pipelineDepthSwitch)
+        CMDLINE_LONG_LONG("--seed", seedSwitch)
+        CMDLINE_HELP("--help", HELP_TEXT)
+    CMDLINE_DEFINITION_END
+
+    exitStatus = cmdLineParse(&argumentCount, argumentValues, switches);
+    if (exitStatus != 0) {
+        cmdLineReportError(exitStatus, argumentValues, switches);
+        cmdLineDeallocate(switches);
+
+        return cmdLineExitCode(exitStatus) == CMDLINE_HELP_REQUESTED ? 0 : 1;
+    }
+
+    if (argumentCount > 1) {
+        fprintf(stderr, "*** Error: Unexpected argument \"%s\".\n", argumentValues[1]);
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    if (socketSwitch != NULL) {
+        socketPath = socketSwitch;
+    }
+
+    if (operationSwitch != NULL) {
+        if (strcmp(operationSwitch, "is-prime") == 0) {
+            operation = PRIME_QUERY_IS_PRIME;
+        } else if (strcmp(operationSwitch, "next-prime") == 0) {
+            operation = PRIME_QUERY_NEXT_PRIME;
+        } else if (strcmp(operationSwitch, "rank") == 0) {
+            operation = PRIME_QUERY_RANK;
+        } else if (strcmp(operationSwitch, "nth") == 0) {
+            operation = PRIME_QUERY_NTH;
+        } else if (strcmp(operationSwitch, "mixed") != 0) {
+            fprintf(stderr, "*** Error: Unknown operation \"%s\".\n", operationSwitch);
+            cmdLineDeallocate(switches);
+
+            return 1;
+        }
+    }
+
+    if ((requestsSwitch != NULL && *requestsSwitch <= 0)
+        || (connectionsSwitch != NULL && *connectionsSwitch <= 0)
+        || (batchSizeSwitch != NULL && *batchSizeSwitch <= 0)
+        || (pipelineDepthSwitch != NULL && *pipelineDepthSwitch <= 0)) {
+        fprintf(stderr, "*** Error: Counts must be positive.\n");
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    numberRequests    = requestsSwitch != NULL ? (unsigned long) *requestsSwitch : numberRequests;
+    numberConnections = connectionsSwitch != NULL ? (unsigned long) *connectionsSwitch : numberConnections;
+    batchSize         = batchSizeSwitch != NULL ? (unsigned long) *batchSizeSwitch : batchSize;
+    pipelineDepth     = pipelineDepthSwitch != NULL ? (unsigned long) *pipelineDepthSwitch : pipelineDepth;
+    seed              = seedSwitch != NULL ? (uint64_t) *seedSwitch : seed;
+
+    if (batchSize > MAXIMUM_REQUESTS_IN_FLIGHT || pipelineDepth > MAXIMUM_REQUESTS_IN_FLIGHT / batchSize) {
+        fprintf(
+            stderr,
+            "*** Error: The batch size times the pipeline depth can not exceed %d.\n",
+            MAXIMUM_REQUESTS_IN_FLIGHT
+        );
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    /* The bounds of the random arguments are taken from the server. */
+
+    fileDescriptor = connectToPrimeServer(socketPath);
+    if (fileDescriptor < 0) {
+        cmdLineDeallocate(switches);
+        return 1;
+    }
+
+    if (query(fileDescriptor, PRIME_QUERY_MAXIMUM_PRIME, 0, &maximumPrime) != 0
+        || query(fileDescriptor, PRIME_QUERY_RANK, maximumPrime, &numberPrimes) != 0) {
+        close(fileDescriptor);
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    close(fileDescriptor);
+
+    generators = malloc(numberConnections * sizeof(LoadGenerator));
+    threads    = malloc(numberConnections * sizeof(pthread_t));
+    assert(generators != NULL && threads != NULL);
+
+    startTime = monotonicNanoseconds();
+
+    for (i=0 ; i<numberConnections ; ++i) {
+        LoadGenerator* generator = generators + i;
+
+        generator->socketPath       = socketPath;
+        generator->operation        = operation;
+        generator->numberRequests   = numberRequests;
+        generator->batchSize        = batchSize;
+        generator->pipelineDepth    = pipelineDepth;
+        generator->maximumPrime     = maximumPrime;
+        generator->numberPrimes     = numberPrimes;
+        generator->randomState      = (seed + i) * 0x9E3779B97F4A7C15ULL | 1;
+        generator->numberOutOfRange = 0;
+        generator->failed           = 0;
+        initializeQueryStatistics(&generator->statistics);
+
+        if (pthread_create(threads + i, NULL, &loadGeneratorThread, generator) != 0) {
+            fprintf(stderr, "*** Error: Could not start a connection thread.\n");
+            exit(1);
+        }
+    }
+
+    initializeQueryStatistics(&statistics);
+
+    for (i=0 ; i<numberConnections ; ++i) {
+        pthread_join(threads[i], NULL);
+
+        mergeQueryStatistics(&statistics, &generators[i].statistics);
+        numberOutOfRange += generators[i].numberOutOfRange;
+
+        if (generators[i].failed) {
+            exitStatus = 1;
+        }
+    }
+
+    printf(
+        "%lu connections, batch size %lu, pipeline depth %lu, %" PRIu64 " primes up to %" PRIx64 ".\n",
+        numberConnections,
+        batchSize,
+        pipelineDepth,
+        numberPrimes,
+        maximumPrime
+    );
+    printf("%llu requests were out of range.\n", numberOutOfRange);
+    reportQueryStatistics(stdout, "Client", &statistics, (monotonicNanoseconds() - startTime) / 1.0E9);
+
+    free(generators);
+    free(threads);
+    cmdLineDeallocate(switches);
+
+    return exitStatus == 0 ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief On-disk layout of a prime list container.
+*
+* This file defines the layout of the single file used to hold a prime list.  The file starts with a
+* \ref PrimeContainerHeader describing how the pools were generated, followed by one \ref PrimeContainerPoolEntry per
+* pool, the rank table, and then the pools themselves.  Each pool starts on a PRIME_CONTAINER_POOL_ALIGNMENT boundary
+* so a pool can be memory mapped on its own.  Pools that were never written are holes in the file.
+*
+* Every field is stored in host byte order.  Bit i of a pool, counting from the least significant bit of the first
+* byte, tracks the odd value 2 * (i + pool index * 8 * pool size) + 1.  A set bit marks a composite value.
+*
+* The rank table holds one 32-bit entry per rank block of each pool, ordered by pool and then by block.  Each entry
+* holds the number of primes in the pool that precede the block.  Together with the pool table, the rank table lets a
+* reader count or locate primes while touching a single block of a single pool.
+***********************************************************************************************************************/
+
+#ifndef PRIME_CONTAINER_H
+#define PRIME_CONTAINER_H
+
+#include <stdint.h>
+
+/*******************************************************************************************************************//**
+* \brief The bytes that start every prime list container.
+***********************************************************************************************************************/
+#define PRIME_CONTAINER_MAGIC ("GF2PLIST")
+
+/*******************************************************************************************************************//**
+* \brief The container version written by this program.
+*
+* You can use this define to detect containers written with a different layout.
+***********************************************************************************************************************/
+#define PRIME_CONTAINER_VERSION (3)
+
+/*******************************************************************************************************************//**
+* \brief The alignment, in bytes, of the first byte of each pool.
+*
+* You can use this define to determine how pools are spaced in the container.  The value is a multiple of the page size
+* of every supported host.
+***********************************************************************************************************************/
+#define PRIME_CONTAINER_POOL_ALIGNMENT (65536)
+
+/*******************************************************************************************************************//**
+* \brief The largest supported pool size, in bytes.
+*
+* You can use this define to bound the pool size.  Rank table entries are 32 bits wide.  A sieved pool of this size
+* tracks 2^33 odd values and holds well under 2^32 primes.
+***********************************************************************************************************************/
+#define PRIME_CONTAINER_MAXIMUM_POOL_SIZE (1024*1024*1024)
+
+/*******************************************************************************************************************//**
+* \brief The size, in bytes, of the pool data covered by each rank table entry.
+*
+* You can use this define to trade the size of the rank table against the number of bits scanned by a rank query.
+***********************************************************************************************************************/
+#define PRIME_CONTAINER_RANK_BLOCK_SIZE (4096)
+
+/*******************************************************************************************************************//**
+* \brief Flag indicating a set bit marks a composite value.
+***********************************************************************************************************************/
+#define PRIME_CONTAINER_COMPOSITE_BITS_SET (0x00000001)
+
+/*******************************************************************************************************************//**
+* \brief Flag indicating only odd values are tracked.
+***********************************************************************************************************************/
+#define PRIME_CONTAINER_ODD_VALUES_ONLY (0x00000002)
+
+/*******************************************************************************************************************//**
+* \brief Value stored in \ref PrimeContainerPoolEntry::numberPrimes when a pool has not been summarized.
+***********************************************************************************************************************/
+#define PRIME_CONTAINER_UNKNOWN (UINT64_MAX)
+
+/*******************************************************************************************************************//**
+* \brief Header found at the start of a prime list container.
+*
+* You can use this structure to read the parameters a prime list was generated with.
+***********************************************************************************************************************/
+typedef struct PrimeContainerHeader {
+    /**
+     * Holds PRIME_CONTAINER_MAGIC without a terminating NUL.
+     */
+    char magic[8];
+
+    /**
+     * Holds PRIME_CONTAINER_VERSION.
+     */
+    uint32_t version;
+
+    /**
+     * Holds the size of this header in bytes.  The pool table follows the header.
+     */
+    uint32_t headerSizeInBytes;
+
+    /**
+     * Holds the largest value tracked by the prime list.
+     */
+    uint64_t maximumPrime;
+
+    /**
+     * Holds the size of each pool in bytes.
+     */
+    uint64_t poolSizeInBytes;
+
+    /**
+     * Holds the puddle size the prime list was generated with.  The bit layout does not depend on the value.
+     */
+    uint32_t puddleSize;
+
+    /**
+     * Holds PRIME_CONTAINER_COMPOSITE_BITS_SET and PRIME_CONTAINER_ODD_VALUES_ONLY.
+     */
+    uint32_t flags;
+
+    /**
+     * Holds the number of pools and pool table entries.
+     */
+    uint64_t numberPools;
+
+    /**
+     * Holds the byte offset of the rank table from the start of the container.
+     */
+    uint64_t rankTableOffset;
+
+    /**
+     * Holds the size, in bytes, of the pool data covered by each rank table entry.  The value is a multiple of 8.
+     */
+    uint32_t rankBlockSizeInBytes;
+
+    /**
+     * Holds the number of rank table entries for each pool.
+     */
+    uint32_t numberRankBlocks;
+} PrimeContainerHeader;
+
+/*******************************************************************************************************************//**
+* \brief Pool table entry describing a single pool.
+*
+* You can use this structure to locate a pool and to skip pools without reading them.  The summary and the pool's rank
+* table entries cover odd values only and are updated each time the pool is written.
+***********************************************************************************************************************/
+typedef struct PrimeContainerPoolEntry {
+    /**
+     * Holds the byte offset of the pool from the start of the container.
+     */
+    uint64_t offset;
+
+    /**
+     * Holds the number of primes in the pool or PRIME_CONTAINER_UNKNOWN if the pool has not been summarized.
+     */
+    uint64_t numberPrimes;
+
+    /**
+     * Holds the first prime in the pool or 0 if the pool holds no primes.
+     */
+    uint64_t firstPrime;
+
+    /**
+     * Holds the last prime in the pool or 0 if the pool holds no primes.
+     */
+    uint64_t lastPrime;
+} PrimeContainerPoolEntry;
+
+#endif
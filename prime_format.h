@@ -0,0 +1,65 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Stream formats used to exchange prime lists.
+*
+* This file defines the formats written by list_primes_gf2 and understood by the prime reader.  Every format holds the
+* primes in ascending order with no header.
+*
+* PRIME_FORMAT_HEX writes each prime as lower case hexadecimal digits followed by a newline.
+*
+* PRIME_FORMAT_U64LE writes each prime as 8 bytes, least significant byte first.
+*
+* PRIME_FORMAT_DELTA_VARINT writes the difference between each prime and the previous prime, with 0 taken as the
+* prime before the first.  Each difference is stored as an unsigned LEB128 value, 7 bits per byte starting with the
+* least significant bits, with the most significant bit of each byte set when more bytes follow.  Differences between
+* consecutive primes are small so most primes take one or two bytes.
+***********************************************************************************************************************/
+
+#ifndef PRIME_FORMAT_H
+#define PRIME_FORMAT_H
+
+#include "compiler.h"
+
+/*******************************************************************************************************************//**
+* \brief The largest number of bytes used by any format to hold one prime.
+***********************************************************************************************************************/
+#define PRIME_FORMAT_MAXIMUM_SIZE (17)
+
+/*******************************************************************************************************************//**
+* \brief Specifies how a list of primes is encoded.
+*
+* You can use this enumeration to select the format of a stream of primes.
+***********************************************************************************************************************/
+typedef enum PrimeFormat {
+    PRIME_FORMAT_HEX,
+    PRIME_FORMAT_U64LE,
+    PRIME_FORMAT_DELTA_VARINT
+} PrimeFormat;
+
+/*******************************************************************************************************************//**
+* \brief Converts the name of a format.
+*
+* You can use this function to convert the names "hex", "u64le", and "delta-varint" used on the command line.  The
+* function is provided by the prime reader library.
+*
+* \param[in]  name   The name to convert.
+*
+* \param[out] format The format with that name.
+*
+* \return Returns 0 on success.  Returns -1 if the name is not recognized.
+***********************************************************************************************************************/
+GF2PRIMES_API int primeFormatFromName(char const* const name, PrimeFormat* const format);
+
+#endif
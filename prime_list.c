@@ -21,228 +21,2018 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <assert.h>
 
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
 
 #include "compiler.h"
 #include "gf2.h"
 
 #include "parameters.h"
+#include "prime_container.h"
 #include "prime_list.h"
 
 
-#define NUMBER_PUDDLES_PER_POOL (POOL_SIZE_IN_BYTES / (PUDDLE_SIZE / 8))
-#define NUMBER_BITS (MAXIMUM_PRIME >> 1)
-#define NUMBER_PUDDLES ((NUMBER_BITS + PUDDLE_SIZE - 1) / PUDDLE_SIZE)
-#define NUMBER_POOLS ((NUMBER_PUDDLES + NUMBER_PUDDLES_PER_POOL - 1) / NUMBER_PUDDLES_PER_POOL)
-#define CREATE_FLAGS (O_CREAT | O_TRUNC | O_APPEND | O_RDWR)
-#define OPEN_FLAGS (O_RDONLY)
 #define MODES (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH)
+#define DIRTY_PAGE_SIZE_IN_BYTES (4096)
 
+#define MAXIMUM_AUTOMATIC_MAPPINGS (16384)
 
-#if (PUDDLE_SIZE == 32)
+#if (POOL_SIZE_IN_BYTES < PRIME_CONTAINER_POOL_ALIGNMENT)
+    #error "POOL_SIZE_IN_BYTES must be at least PRIME_CONTAINER_POOL_ALIGNMENT."
+#endif
+
+#if (POOL_SIZE_IN_BYTES > PRIME_CONTAINER_MAXIMUM_POOL_SIZE)
+    #error "POOL_SIZE_IN_BYTES must be at most PRIME_CONTAINER_MAXIMUM_POOL_SIZE."
+#endif
+
+
+typedef struct PoolCacheEntry {
+    void*              puddles;
+    unsigned long      poolIndex;
+    int                isDirty;
+    uint64_t*          dirtyPages;
+    unsigned long long lastUse;
+} PoolCacheEntry;
+
+
+typedef struct PoolTransfer {
+    PrimeList*      primeList;
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    int             isRunning;
+    int             isStopping;
+    void const*     writePuddles;
+    uint64_t const* writePages;
+    unsigned long   writePoolIndex;
+    void*           readPuddles;
+    unsigned long   readPoolIndex;
+    int             readIsComplete;
+} PoolTransfer;
+
+
+struct PoolBuffer {
+    PrimeList*    primeList;
+    void*         puddles;
+    unsigned long poolIndex;
+    int           isDirty;
+    void*         writePuddles;
+    void*         freePuddles[3];
+    unsigned      numberFreePuddles;
+    PoolTransfer  transfer;
+};
+
+
+struct PrimeList {
+    PrimeListConfiguration   configuration;
+    PrimeListOpenMode        openMode;
+    Gf2Polynomial            numberBits;
+    Gf2Polynomial            bitsPerPool;
+    unsigned long            numberPools;
+    void*                    inMemoryPool;
+    unsigned long            inMemoryPoolIndex;
+    int                      inMemoryPoolIsDirty;
+    char*                    filePrefix;
+    char*                    containerFilename;
+    int                      containerFile;
+    uint64_t                 poolTableOffset;
+    uint64_t                 rankTableOffset;
+    Gf2Polynomial            bitsPerRankBlock;
+    unsigned long            numberRankBlocks;
+    void**                   residentPools;
+    int                      allPoolsResident;
+    void*                    memoryPools;
+    unsigned char*           memoryPoolIsDirty;
+    PrimeContainerPoolEntry* poolTable;
+    uint32_t*                rankTable;
+    void*                    rankMapping;
+    size_t                   rankMappingSize;
+    uint64_t*                poolRanks;
+    int                      poolRanksAreValid;
+    PoolCacheEntry*          poolCache;
+    unsigned long            poolCacheSize;
+    PoolCacheEntry*          residentEntry;
+    unsigned long long       poolCacheClock;
+    unsigned long long       poolCacheHits;
+    unsigned long long       poolCacheMisses;
+    PoolTransfer             poolCacheTransfer;
+    void*                    poolCacheSpare;
+    void*                    poolCacheWritePuddles;
+    uint64_t*                poolCacheWritePages;
+    unsigned long            poolCacheWriteIndex;
+    PrimeListAccessPattern   mappedPoolAdvice;
+    unsigned long            numberDirtyPages;
+    unsigned long long       poolBytesWritten;
+    pthread_mutex_t          poolStatisticsLock;
+};
+
+
+/* The helpers below take the puddle size as a parameter.  Callers dispatch on the configured puddle size and pass a
+ * constant so the compiler can generate a copy of each hot loop for every supported puddle width.  A set bit marks a
+ * composite value so a pool that was never written reads back as all candidates. */
+
+INLINE void markPuddleBit(void* const puddles, Gf2Polynomial const bit, unsigned const puddleSize) {
+    if (puddleSize == 32) {
+        ((uint32_t*) puddles)[bit / 32] |= (uint32_t) 1 << (bit % 32);
+    } else {
+        ((uint64_t*) puddles)[bit / 64] |= (uint64_t) 1 << (bit % 64);
+    }
+}
+
+
+INLINE int testPuddleBit(void const* const puddles, Gf2Polynomial const bit, unsigned const puddleSize) {
+    if (puddleSize == 32) {
+        return (((uint32_t const*) puddles)[bit / 32] >> (bit % 32)) & 1;
+    } else {
+        return (((uint64_t const*) puddles)[bit / 64] >> (bit % 64)) & 1;
+    }
+}
+
+
+INLINE Gf2Polynomial findClearPuddleBit(
+        void const* const   puddles,
+        Gf2Polynomial const firstBit,
+        Gf2Polynomial const endBit,
+        unsigned const      puddleSize
+    ) {
+    Gf2Polynomial index  = firstBit / puddleSize;
+    Gf2Polynomial result = endBit;
+
+    if (puddleSize == 32) {
+        uint32_t const* p     = (uint32_t const*) puddles;
+        uint32_t        entry = ~p[index] & ((uint32_t) -1 << (firstBit % 32));
+
+        while (entry == 0 && (index + 1) * 32 < endBit) {
+            entry = ~p[++index];
+        }
+
+        if (entry != 0) {
+            result = index * 32 + countTrailingZeros32(entry);
+        }
+    } else {
+        uint64_t const* p     = (uint64_t const*) puddles;
+        uint64_t        entry = ~p[index] & ((uint64_t) -1 << (firstBit % 64));
+
+        while (entry == 0 && (index + 1) * 64 < endBit) {
+            entry = ~p[++index];
+        }
+
+        if (entry != 0) {
+            result = index * 64 + countTrailingZeros64(entry);
+        }
+    }
+
+    return result < endBit ? result : endBit;
+}
+
+
+static void containerFailed(PrimeList const* const primeList, char const* const operation) {
+    /* Pool I/O is performed deep inside the sieve and by the pool transfer threads where there is no caller that could
+     * recover, so a failure ends the program rather than leaving a container that silently lost marks. */
+
+    fprintf(stderr, "*** Error: Unable to %s %s: %s.\n", operation, primeList->containerFilename, strerror(errno));
+    exit(1);
+}
+
+
+static void syncContainer(PrimeList const* const primeList) {
+    if (fsync(primeList->containerFile) != 0) {
+        containerFailed(primeList, "sync");
+    }
+}
+
+
+static void writeFully(PrimeList* const primeList, void const* const data, size_t const size, off_t const offset) {
+    char const* bytes     = (char const*) data;
+    size_t      remaining = size;
+    off_t       position  = offset;
+
+    while (remaining > 0) {
+        ssize_t bytesWritten = pwrite(primeList->containerFile, bytes, remaining, position);
+
+        if (bytesWritten < 0 && errno == EINTR) {
+            bytesWritten = 0;
+        } else if (bytesWritten <= 0) {
+            containerFailed(primeList, "write");
+        }
+
+        bytes     += bytesWritten;
+        position  += bytesWritten;
+        remaining -= bytesWritten;
+    }
+}
+
+
+static int readFully(PrimeList* const primeList, void* const data, size_t const size, off_t const offset) {
+    char*  bytes     = (char*) data;
+    size_t remaining = size;
+    off_t  position  = offset;
+
+    while (remaining > 0) {
+        ssize_t bytesRead = pread(primeList->containerFile, bytes, remaining, position);
+
+        if (bytesRead < 0 && errno == EINTR) {
+            bytesRead = 0;
+        } else if (bytesRead <= 0) {
+            return -1;
+        }
+
+        bytes     += bytesRead;
+        position  += bytesRead;
+        remaining -= bytesRead;
+    }
+
+    return 0;
+}
+
+
+static void computePoolSummary(PrimeList* const primeList, unsigned long const poolIndex, void const* const puddles) {
+    PrimeContainerPoolEntry* entry         = primeList->poolTable + poolIndex;
+    uint32_t*                ranks         = primeList->rankTable + poolIndex * primeList->numberRankBlocks;
+    uint64_t const*          words         = (uint64_t const*) puddles;
+    Gf2Polynomial            bitsPerPool   = primeList->bitsPerPool;
+    Gf2Polynomial            poolFirstBit  = (Gf2Polynomial) poolIndex * bitsPerPool;
+    Gf2Polynomial            numberValid   = primeList->numberBits - poolFirstBit;
+    Gf2Polynomial            numberWords;
+    Gf2Polynomial            wordsPerBlock = primeList->bitsPerRankBlock / 64;
+    Gf2Polynomial            firstBit;
+    Gf2Polynomial            lastBit;
+    uint64_t                 numberPrimes  = 0;
+    Gf2Polynomial            i;
+
+    /* Clear bits are primes.  Bits past the maximum prime in the last word are treated as composite.  Blocks past the
+     * maximum prime hold the pool's total so a rank query never needs to look at them. */
+
+    if (numberValid > bitsPerPool) {
+        numberValid = bitsPerPool;
+    }
+
+    numberWords = (numberValid + 63) / 64;
+    firstBit    = numberValid;
+    lastBit     = numberValid;
+
+    for (i=0 ; i<numberWords ; ++i) {
+        uint64_t candidates = ~words[i];
+
+        if (i % wordsPerBlock == 0) {
+            ranks[i / wordsPerBlock] = (uint32_t) numberPrimes;
+        }
+
+        if (i == numberWords - 1 && numberValid % 64 != 0) {
+            candidates &= ((uint64_t) 1 << (numberValid % 64)) - 1;
+        }
+
+        if (candidates != 0) {
+            if (firstBit == numberValid) {
+                firstBit = i * 64 + countTrailingZeros64(candidates);
+            }
+
+            lastBit       = i * 64 + 63 - countLeadingZeros64(candidates);
+            numberPrimes += countOnes64(candidates);
+        }
+    }
+
+    for (i=(numberWords + wordsPerBlock - 1) / wordsPerBlock ; i<primeList->numberRankBlocks ; ++i) {
+        ranks[i] = (uint32_t) numberPrimes;
+    }
+
+    entry->numberPrimes = numberPrimes;
+    entry->firstPrime   = numberPrimes > 0 ? 2 * (poolFirstBit + firstBit) + 1 : 0;
+    entry->lastPrime    = numberPrimes > 0 ? 2 * (poolFirstBit + lastBit) + 1 : 0;
+
+    pthread_mutex_lock(&primeList->poolStatisticsLock);
+    primeList->poolRanksAreValid = 0;
+    pthread_mutex_unlock(&primeList->poolStatisticsLock);
+}
+
+
+static void summarizePool(PrimeList* const primeList, unsigned long const poolIndex, void const* const puddles) {
+    size_t entryBytes = sizeof(PrimeContainerPoolEntry);
+
+    /* A writer's rank table is a shared mapping of the container so the pool's rank blocks reach the file with the
+     * next sync of the container. */
+
+    computePoolSummary(primeList, poolIndex, puddles);
+
+    writeFully(
+        primeList,
+        primeList->poolTable + poolIndex,
+        entryBytes,
+        primeList->poolTableOffset + poolIndex * entryBytes
+    );
+}
+
+
+static void writePoolFile(PrimeList* const primeList, unsigned long const poolIndex, void const* const puddles) {
+    /* Pools are updated in place.  Marks only ever set bits, so an interrupted write leaves every bit either at its
+     * old value or at its new value and the pool is still valid for a resumed run. */
+
+    writeFully(primeList, puddles, primeList->configuration.poolSizeInBytes, primeList->poolTable[poolIndex].offset);
+    summarizePool(primeList, poolIndex, puddles);
+
+    syncContainer(primeList);
+
+    pthread_mutex_lock(&primeList->poolStatisticsLock);
+    primeList->poolBytesWritten += primeList->configuration.poolSizeInBytes;
+    pthread_mutex_unlock(&primeList->poolStatisticsLock);
+}
+
+
+static void writeDirtyPages(
+        PrimeList* const      primeList,
+        unsigned long const   poolIndex,
+        void const* const     puddles,
+        uint64_t const* const dirtyPages
+    ) {
+    char const*   data         = (char const*) puddles;
+    unsigned long bytesWritten = 0;
+    unsigned long page         = 0;
+
+    while (page < primeList->numberDirtyPages) {
+        if ((dirtyPages[page / 64] >> (page % 64)) & 1) {
+            unsigned long endPage = page + 1;
+            size_t        offset;
+            size_t        size;
+
+            while (endPage < primeList->numberDirtyPages && ((dirtyPages[endPage / 64] >> (endPage % 64)) & 1)) {
+                ++endPage;
+            }
+
+            offset = (size_t) page * DIRTY_PAGE_SIZE_IN_BYTES;
+            size   = (size_t) endPage * DIRTY_PAGE_SIZE_IN_BYTES;
+            if (size > primeList->configuration.poolSizeInBytes) {
+                size = primeList->configuration.poolSizeInBytes;
+            }
+
+            size -= offset;
+
+            writeFully(primeList, data + offset, size, primeList->poolTable[poolIndex].offset + offset);
+            bytesWritten += size;
+
+            page = endPage;
+        } else {
+            ++page;
+        }
+    }
+
+    summarizePool(primeList, poolIndex, puddles);
+    syncContainer(primeList);
+
+    pthread_mutex_lock(&primeList->poolStatisticsLock);
+    primeList->poolBytesWritten += bytesWritten;
+    pthread_mutex_unlock(&primeList->poolStatisticsLock);
+}
+
+
+static void computeLayout(PrimeList* const primeList) {
+    /* Bit i tracks the odd value 2i+1 so (maximumPrime + 1) / 2 bits cover every odd value up to the maximum prime. */
+
+    Gf2Polynomial numberBits  = (primeList->configuration.maximumPrime + 1) / 2;
+    Gf2Polynomial bitsPerPool = 8 * (Gf2Polynomial) primeList->configuration.poolSizeInBytes;
+
+    primeList->numberBits       = numberBits;
+    primeList->bitsPerPool      = bitsPerPool;
+    primeList->numberPools      = (numberBits + bitsPerPool - 1) / bitsPerPool;
+    primeList->numberDirtyPages = (bitsPerPool / 8 + DIRTY_PAGE_SIZE_IN_BYTES - 1) / DIRTY_PAGE_SIZE_IN_BYTES;
+    primeList->numberRankBlocks = (bitsPerPool + primeList->bitsPerRankBlock - 1) / primeList->bitsPerRankBlock;
+}
+
+
+static int mapRankTable(PrimeList* const primeList) {
+    size_t rankTableBytes = primeList->numberPools * primeList->numberRankBlocks * sizeof(uint32_t);
+    off_t  pageSize       = sysconf(_SC_PAGESIZE);
+    off_t  mappingOffset  = primeList->rankTableOffset - primeList->rankTableOffset % pageSize;
+    size_t leadingBytes   = primeList->rankTableOffset - mappingOffset;
+    int    writable       = primeList->openMode != PRIME_FILE_OPEN_FOR_READING;
+
+    /* The rank table is mapped rather than read so opening a list does not depend on its size and a pool's rank blocks
+     * are only paged in once the pool is queried.  Readers map the table privately since the summaries of pools that
+     * were never written are computed in memory only. */
+
+    primeList->rankMappingSize = leadingBytes + rankTableBytes;
+    primeList->rankMapping     = mmap(
+        NULL,
+        primeList->rankMappingSize,
+        PROT_READ | PROT_WRITE,
+        writable ? MAP_SHARED : MAP_PRIVATE,
+        primeList->containerFile,
+        mappingOffset
+    );
+
+    if (primeList->rankMapping == MAP_FAILED) {
+        fprintf(stderr, "*** Error: Unable to map %s: %s.\n", primeList->containerFilename, strerror(errno));
+        primeList->rankMapping = NULL;
+        return -1;
+    }
+
+    primeList->rankTable = (uint32_t*) ((char*) primeList->rankMapping + leadingBytes);
+
+    return 0;
+}
+
+
+static int createContainer(PrimeList* const primeList) {
+    size_t               poolTableBytes = primeList->numberPools * sizeof(PrimeContainerPoolEntry);
+    size_t               rankTableBytes = primeList->numberPools * primeList->numberRankBlocks * sizeof(uint32_t);
+    PrimeContainerHeader header;
+    uint64_t             poolStride;
+    uint64_t             firstPoolOffset;
+    unsigned long        poolIndex;
+    int                  status;
+
+    primeList->containerFile = open(primeList->containerFilename, O_CREAT | O_TRUNC | O_RDWR, MODES);
+    if (primeList->containerFile < 0) {
+        fprintf(stderr, "*** Error: Unable to create %s: %s.\n", primeList->containerFilename, strerror(errno));
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PRIME_CONTAINER_MAGIC, sizeof(header.magic));
+    header.version           = PRIME_CONTAINER_VERSION;
+    header.headerSizeInBytes = sizeof(PrimeContainerHeader);
+    header.maximumPrime      = primeList->configuration.maximumPrime;
+    header.poolSizeInBytes   = primeList->configuration.poolSizeInBytes;
+    header.puddleSize        = primeList->configuration.puddleSize;
+    header.flags             = PRIME_CONTAINER_COMPOSITE_BITS_SET | PRIME_CONTAINER_ODD_VALUES_ONLY;
+    header.numberPools       = primeList->numberPools;
+
+    primeList->poolTableOffset = header.headerSizeInBytes;
+    primeList->rankTableOffset = primeList->poolTableOffset + poolTableBytes;
+
+    header.rankTableOffset      = primeList->rankTableOffset;
+    header.rankBlockSizeInBytes = primeList->bitsPerRankBlock / 8;
+    header.numberRankBlocks     = primeList->numberRankBlocks;
+
+    poolStride       = primeList->configuration.poolSizeInBytes + PRIME_CONTAINER_POOL_ALIGNMENT - 1;
+    poolStride      -= poolStride % PRIME_CONTAINER_POOL_ALIGNMENT;
+    firstPoolOffset  = primeList->rankTableOffset + rankTableBytes + PRIME_CONTAINER_POOL_ALIGNMENT - 1;
+    firstPoolOffset -= firstPoolOffset % PRIME_CONTAINER_POOL_ALIGNMENT;
+
+    for (poolIndex=0 ; poolIndex<primeList->numberPools ; ++poolIndex) {
+        primeList->poolTable[poolIndex].offset       = firstPoolOffset + poolIndex * poolStride;
+        primeList->poolTable[poolIndex].numberPrimes = PRIME_CONTAINER_UNKNOWN;
+        primeList->poolTable[poolIndex].firstPrime   = 0;
+        primeList->poolTable[poolIndex].lastPrime    = 0;
+    }
+
+    writeFully(primeList, &header, sizeof(header), 0);
+    writeFully(primeList, primeList->poolTable, poolTableBytes, primeList->poolTableOffset);
+
+    /* A new pool holds no composites, so the pools are left as holes that read back as zeros.  The rank table is also
+     * left as a hole since the entries of a pool are only used once the pool has been summarized. */
+
+    status = ftruncate(primeList->containerFile, firstPoolOffset + primeList->numberPools * poolStride);
+    if (status != 0) {
+        fprintf(stderr, "*** Error: Unable to size %s: %s.\n", primeList->containerFilename, strerror(errno));
+        return -1;
+    }
+
+    return mapRankTable(primeList);
+}
+
+
+static int openContainer(PrimeList* const primeList, PrimeListOpenMode const openMode) {
+    int                  flags = openMode == PRIME_FILE_OPEN_FOR_READING ? O_RDONLY : O_RDWR;
+    PrimeContainerHeader header;
+    struct stat          fileStatus;
+    size_t               poolTableBytes;
+    size_t               rankTableBytes;
+    unsigned long        poolIndex;
+    int                  valid;
+
+    primeList->containerFile = open(primeList->containerFilename, flags);
+    if (primeList->containerFile < 0) {
+        fprintf(stderr, "*** Error: Unable to open %s.\n", primeList->containerFilename);
+        return -1;
+    }
+
+    valid = (
+           readFully(primeList, &header, sizeof(header), 0) == 0
+        && memcmp(header.magic, PRIME_CONTAINER_MAGIC, sizeof(header.magic)) == 0
+        && header.version == PRIME_CONTAINER_VERSION
+        && header.headerSizeInBytes >= sizeof(PrimeContainerHeader)
+        && header.flags == (PRIME_CONTAINER_COMPOSITE_BITS_SET | PRIME_CONTAINER_ODD_VALUES_ONLY)
+        && (header.puddleSize == 32 || header.puddleSize == 64)
+        && header.poolSizeInBytes > 0
+        && header.poolSizeInBytes <= PRIME_CONTAINER_MAXIMUM_POOL_SIZE
+        && header.poolSizeInBytes % 8 == 0
+        && header.maximumPrime >= 3
+        && header.rankTableOffset % sizeof(uint32_t) == 0
+        && header.rankBlockSizeInBytes > 0
+        && header.rankBlockSizeInBytes % 8 == 0
+    );
+
+    if (!valid) {
+        fprintf(stderr, "*** Error: %s is not a prime list container.\n", primeList->containerFilename);
+        return -1;
+    }
+
+    /* Readers take the layout from the container.  An update must match the layout the container was created with. */
+
+    if (openMode == PRIME_FILE_OPEN_FOR_READING) {
+        primeList->configuration.maximumPrime    = header.maximumPrime;
+        primeList->configuration.poolSizeInBytes = header.poolSizeInBytes;
+        primeList->configuration.puddleSize      = header.puddleSize;
+    } else if (   header.maximumPrime != primeList->configuration.maximumPrime
+               || header.poolSizeInBytes != primeList->configuration.poolSizeInBytes
+               || header.puddleSize != primeList->configuration.puddleSize) {
+        fprintf(stderr, "*** Error: %s was created with different parameters.\n", primeList->containerFilename);
+        return -1;
+    }
+
+    primeList->bitsPerRankBlock = 8 * (Gf2Polynomial) header.rankBlockSizeInBytes;
+    computeLayout(primeList);
+
+    if (header.numberPools != primeList->numberPools || header.numberRankBlocks != primeList->numberRankBlocks) {
+        fprintf(stderr, "*** Error: %s has an inconsistent pool table.\n", primeList->containerFilename);
+        return -1;
+    }
+
+    poolTableBytes = primeList->numberPools * sizeof(PrimeContainerPoolEntry);
+    rankTableBytes = primeList->numberPools * primeList->numberRankBlocks * sizeof(uint32_t);
+
+    primeList->poolTableOffset = header.headerSizeInBytes;
+    primeList->poolTable       = malloc(poolTableBytes);
+    assert(primeList->poolTable != NULL);
+
+    if (readFully(primeList, primeList->poolTable, poolTableBytes, primeList->poolTableOffset) != 0) {
+        fprintf(stderr, "*** Error: %s has a truncated pool table.\n", primeList->containerFilename);
+        return -1;
+    }
+
+    /* The rank table is mapped so it must lie within the file.  Reading past the end of a mapping faults. */
+
+    primeList->rankTableOffset = header.rankTableOffset;
+
+    if (fstat(primeList->containerFile, &fileStatus) != 0
+        || (uint64_t) fileStatus.st_size < primeList->rankTableOffset + rankTableBytes) {
+        fprintf(stderr, "*** Error: %s has a truncated rank table.\n", primeList->containerFilename);
+        return -1;
+    }
+
+    for (poolIndex=0 ; poolIndex<primeList->numberPools ; ++poolIndex) {
+        if (primeList->poolTable[poolIndex].offset % PRIME_CONTAINER_POOL_ALIGNMENT != 0) {
+            fprintf(stderr, "*** Error: %s has a misaligned pool.\n", primeList->containerFilename);
+            return -1;
+        }
+    }
+
+    return mapRankTable(primeList);
+}
+
+
+static void readPoolFile(PrimeList* const primeList, unsigned long const poolIndex, void* const puddles) {
+    off_t offset = primeList->poolTable[poolIndex].offset;
+
+    if (readFully(primeList, puddles, primeList->configuration.poolSizeInBytes, offset) != 0) {
+        containerFailed(primeList, "read");
+    }
+}
+
+
+/* A pool transfer is a background thread that performs at most one pool write and one pool read at a time so pool
+ * I/O overlaps with sieving.  Writes are performed before reads.  A write given a dirty page map only writes the
+ * modified pages.  The thread is only started once it is first needed. */
+
+static void* poolTransferThread(void* argument) {
+    PoolTransfer* transfer  = (PoolTransfer*) argument;
+    PrimeList*    primeList = transfer->primeList;
+
+    pthread_mutex_lock(&transfer->lock);
+
+    while (!transfer->isStopping || transfer->writePoolIndex != (unsigned long) -1) {
+        if (transfer->writePoolIndex != (unsigned long) -1) {
+            unsigned long   poolIndex  = transfer->writePoolIndex;
+            void const*     puddles    = transfer->writePuddles;
+            uint64_t const* dirtyPages = transfer->writePages;
+
+            pthread_mutex_unlock(&transfer->lock);
+
+            if (dirtyPages != NULL) {
+                writeDirtyPages(primeList, poolIndex, puddles, dirtyPages);
+            } else {
+                writePoolFile(primeList, poolIndex, puddles);
+            }
+
+            pthread_mutex_lock(&transfer->lock);
+
+            transfer->writePoolIndex = (unsigned long) -1;
+            pthread_cond_broadcast(&transfer->changed);
+        } else if (transfer->readPoolIndex != (unsigned long) -1 && !transfer->readIsComplete) {
+            unsigned long poolIndex = transfer->readPoolIndex;
+            void*         puddles   = transfer->readPuddles;
+
+            pthread_mutex_unlock(&transfer->lock);
+            readPoolFile(primeList, poolIndex, puddles);
+            pthread_mutex_lock(&transfer->lock);
+
+            transfer->readIsComplete = 1;
+            pthread_cond_broadcast(&transfer->changed);
+        } else {
+            pthread_cond_wait(&transfer->changed, &transfer->lock);
+        }
+    }
+
+    pthread_mutex_unlock(&transfer->lock);
+
+    return NULL;
+}
+
+
+static void initializePoolTransfer(PrimeList* const primeList, PoolTransfer* const transfer) {
+    pthread_mutex_init(&transfer->lock, NULL);
+    pthread_cond_init(&transfer->changed, NULL);
+
+    transfer->primeList      = primeList;
+    transfer->isRunning      = 0;
+    transfer->isStopping     = 0;
+    transfer->writePuddles   = NULL;
+    transfer->writePages     = NULL;
+    transfer->writePoolIndex = (unsigned long) -1;
+    transfer->readPuddles    = NULL;
+    transfer->readPoolIndex  = (unsigned long) -1;
+    transfer->readIsComplete = 0;
+}
+
+
+static void startPoolTransfer(PoolTransfer* const transfer) {
+    if (!transfer->isRunning) {
+        int status = pthread_create(&transfer->thread, NULL, &poolTransferThread, transfer);
+        assert(status == 0);
+
+        transfer->isRunning = 1;
+    }
+}
+
+
+static void waitForPoolWrite(PoolTransfer* const transfer) {
+    pthread_mutex_lock(&transfer->lock);
+
+    while (transfer->writePoolIndex != (unsigned long) -1) {
+        pthread_cond_wait(&transfer->changed, &transfer->lock);
+    }
+
+    pthread_mutex_unlock(&transfer->lock);
+}
+
+
+static void queuePoolWrite(
+        PoolTransfer* const   transfer,
+        unsigned long const   poolIndex,
+        void const* const     puddles,
+        uint64_t const* const dirtyPages
+    ) {
+    startPoolTransfer(transfer);
+    waitForPoolWrite(transfer);
+
+    pthread_mutex_lock(&transfer->lock);
+
+    transfer->writePuddles   = puddles;
+    transfer->writePages     = dirtyPages;
+    transfer->writePoolIndex = poolIndex;
+
+    pthread_cond_broadcast(&transfer->changed);
+    pthread_mutex_unlock(&transfer->lock);
+}
+
+
+static void queuePoolRead(PoolTransfer* const transfer, unsigned long const poolIndex, void* const puddles) {
+    startPoolTransfer(transfer);
+
+    pthread_mutex_lock(&transfer->lock);
+
+    assert(transfer->readPoolIndex == (unsigned long) -1);
+
+    transfer->readPuddles    = puddles;
+    transfer->readPoolIndex  = poolIndex;
+    transfer->readIsComplete = 0;
+
+    pthread_cond_broadcast(&transfer->changed);
+    pthread_mutex_unlock(&transfer->lock);
+}
+
+
+static void* finishPoolRead(PoolTransfer* const transfer, unsigned long* const poolIndex) {
+    void* result = NULL;
+
+    pthread_mutex_lock(&transfer->lock);
+
+    if (transfer->readPoolIndex != (unsigned long) -1) {
+        while (!transfer->readIsComplete) {
+            pthread_cond_wait(&transfer->changed, &transfer->lock);
+        }
+
+        result     = transfer->readPuddles;
+        *poolIndex = transfer->readPoolIndex;
+
+        transfer->readPuddles   = NULL;
+        transfer->readPoolIndex = (unsigned long) -1;
+    }
+
+    pthread_mutex_unlock(&transfer->lock);
+
+    return result;
+}
+
+
+static void terminatePoolTransfer(PoolTransfer* const transfer) {
+    if (transfer->isRunning) {
+        pthread_mutex_lock(&transfer->lock);
+        transfer->isStopping = 1;
+        pthread_cond_broadcast(&transfer->changed);
+        pthread_mutex_unlock(&transfer->lock);
+
+        pthread_join(transfer->thread, NULL);
+        transfer->isRunning = 0;
+    }
+
+    pthread_mutex_destroy(&transfer->lock);
+    pthread_cond_destroy(&transfer->changed);
+}
+
+
+static int adviceFlags(PrimeListAccessPattern const accessPattern) {
+    int result;
+
+    switch (accessPattern) {
+        case PRIME_LIST_ACCESS_SEQUENTIAL: { result = MADV_SEQUENTIAL; break; }
+        case PRIME_LIST_ACCESS_RANDOM:     { result = MADV_RANDOM;     break; }
+        default:                           { result = MADV_NORMAL;     break; }
+    }
+
+    return result;
+}
+
+
+static void* mapPoolFile(PrimeList* const primeList, unsigned long const poolIndex) {
+    int   writable = primeList->openMode != PRIME_FILE_OPEN_FOR_READING;
+    void* mapping;
+
+    mapping = mmap(
+        NULL,
+        primeList->configuration.poolSizeInBytes,
+        writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+        MAP_SHARED,
+        primeList->containerFile,
+        primeList->poolTable[poolIndex].offset
+    );
+    if (mapping == MAP_FAILED) {
+        containerFailed(primeList, "map");
+    }
+
+    madvise(mapping, primeList->configuration.poolSizeInBytes, adviceFlags(primeList->mappedPoolAdvice));
+
+    return mapping;
+}
+
+
+static void unmapPoolFiles(PrimeList* const primeList) {
+    size_t        poolSize = primeList->configuration.poolSizeInBytes;
+    unsigned long poolIndex;
+    int           status;
+
+    for (poolIndex=0 ; poolIndex<primeList->numberPools ; ++poolIndex) {
+        if (primeList->residentPools[poolIndex] != NULL) {
+            if (primeList->openMode != PRIME_FILE_OPEN_FOR_READING) {
+                if (msync(primeList->residentPools[poolIndex], poolSize, MS_SYNC) != 0) {
+                    containerFailed(primeList, "write");
+                }
+
+                summarizePool(primeList, poolIndex, primeList->residentPools[poolIndex]);
+            }
+
+            status = munmap(primeList->residentPools[poolIndex], poolSize);
+            assert(status == 0);
+
+            primeList->residentPools[poolIndex] = NULL;
+        }
+    }
+
+    if (primeList->openMode != PRIME_FILE_OPEN_FOR_READING) {
+        syncContainer(primeList);
+    }
+
+    primeList->inMemoryPool      = NULL;
+    primeList->inMemoryPoolIndex = (unsigned long) -1;
+}
+
+
+static void flushInMemoryPool(PrimeList* const primeList) {
+    /* The resident pool's changes are recorded in its cache entry or, when every pool is held in memory, in the pool's
+     * dirty flag.  Mapped pools have neither since their modified pages are written back by the kernel. */
+
+    if (primeList->inMemoryPoolIsDirty) {
+        if (primeList->residentEntry != NULL) {
+            primeList->residentEntry->isDirty = 1;
+        } else if (primeList->memoryPoolIsDirty != NULL) {
+            primeList->memoryPoolIsDirty[primeList->inMemoryPoolIndex] = 1;
+        }
+    }
+
+    primeList->inMemoryPoolIsDirty = 0;
+}
+
+
+static void writeCachedPool(PrimeList* const primeList, PoolCacheEntry* const entry) {
+    if (entry->isDirty) {
+        writeDirtyPages(primeList, entry->poolIndex, entry->puddles, entry->dirtyPages);
+        memset(entry->dirtyPages, 0, ((primeList->numberDirtyPages + 63) / 64) * sizeof(uint64_t));
+
+        entry->isDirty = 0;
+    }
+}
+
+
+static void queueCachedPoolWrite(PrimeList* const primeList, PoolCacheEntry* const entry) {
+    void*     puddles    = primeList->poolCacheWritePuddles;
+    uint64_t* dirtyPages = primeList->poolCacheWritePages;
+
+    /* The entry's buffers are handed to the pool transfer and the entry takes over the buffers of the previous write,
+     * which queuePoolWrite waits for.  The entry's pool buffer is allocated by the caller the first time. */
+
+    queuePoolWrite(&primeList->poolCacheTransfer, entry->poolIndex, entry->puddles, entry->dirtyPages);
+
+    primeList->poolCacheWritePuddles = entry->puddles;
+    primeList->poolCacheWritePages   = entry->dirtyPages;
+    primeList->poolCacheWriteIndex   = entry->poolIndex;
+
+    if (dirtyPages == NULL) {
+        dirtyPages = calloc((primeList->numberDirtyPages + 63) / 64, sizeof(uint64_t));
+        assert(dirtyPages != NULL);
+    } else {
+        memset(dirtyPages, 0, ((primeList->numberDirtyPages + 63) / 64) * sizeof(uint64_t));
+    }
+
+    entry->puddles    = puddles;
+    entry->dirtyPages = dirtyPages;
+    entry->isDirty    = 0;
+}
+
+
+static void flushPoolCache(PrimeList* const primeList) {
+    unsigned long i;
+    unsigned long prefetchedIndex;
+    void*         prefetched;
+
+    flushInMemoryPool(primeList);
+
+    /* A prefetched pool may be replaced through a pool buffer once the cache is flushed so it is discarded. */
+
+    prefetched = finishPoolRead(&primeList->poolCacheTransfer, &prefetchedIndex);
+    if (prefetched != NULL) {
+        primeList->poolCacheSpare = prefetched;
+    }
+
+    for (i=0 ; i<primeList->poolCacheSize ; ++i) {
+        PoolCacheEntry* entry = primeList->poolCache + i;
+
+        writeCachedPool(primeList, entry);
+        entry->poolIndex = (unsigned long) -1;
+    }
+
+    waitForPoolWrite(&primeList->poolCacheTransfer);
+
+    primeList->residentEntry     = NULL;
+    primeList->inMemoryPool      = NULL;
+    primeList->inMemoryPoolIndex = (unsigned long) -1;
+}
+
+
+static void writeMemoryPools(PrimeList* const primeList) {
+    size_t        poolSize      = primeList->configuration.poolSizeInBytes;
+    unsigned long numberWritten = 0;
+    unsigned long poolIndex;
+
+    /* Pools held in memory only reach the container here so every modified pool is written with a single fsync. */
+
+    for (poolIndex=0 ; poolIndex<primeList->numberPools ; ++poolIndex) {
+        if (primeList->memoryPoolIsDirty[poolIndex]) {
+            off_t offset = primeList->poolTable[poolIndex].offset;
+
+            writeFully(primeList, primeList->residentPools[poolIndex], poolSize, offset);
+            summarizePool(primeList, poolIndex, primeList->residentPools[poolIndex]);
+
+            primeList->memoryPoolIsDirty[poolIndex] = 0;
+            ++numberWritten;
+        }
+    }
+
+    if (numberWritten > 0) {
+        syncContainer(primeList);
+
+        pthread_mutex_lock(&primeList->poolStatisticsLock);
+        primeList->poolBytesWritten += (unsigned long long) numberWritten * poolSize;
+        pthread_mutex_unlock(&primeList->poolStatisticsLock);
+    }
+}
+
+
+static PoolCacheEntry* findCachedPool(PrimeList* const primeList, unsigned long const poolIndex) {
+    PoolCacheEntry* result = NULL;
+    unsigned long   i;
+
+    for (i=0 ; result == NULL && i<primeList->poolCacheSize ; ++i) {
+        if (primeList->poolCache[i].poolIndex == poolIndex) {
+            result = primeList->poolCache + i;
+        }
+    }
+
+    return result;
+}
+
+
+static PoolCacheEntry* loadCachedPool(PrimeList* const primeList, unsigned long const poolIndex) {
+    PoolCacheEntry* result = findCachedPool(primeList, poolIndex);
+
+    if (result != NULL) {
+        ++primeList->poolCacheHits;
+    } else {
+        PoolCacheEntry* victim = primeList->poolCache;
+        unsigned long   prefetchedIndex;
+        void*           prefetched;
+        unsigned long   i;
+
+        ++primeList->poolCacheMisses;
+
+        /* Evict the least recently used pool.  Unused entries were never touched so they are evicted first. */
+
+        for (i=1 ; i<primeList->poolCacheSize ; ++i) {
+            if (primeList->poolCache[i].lastUse < victim->lastUse) {
+                victim = primeList->poolCache + i;
+            }
+        }
+
+        /* A dirty victim is written back by the pool transfer while the requested pool is loaded into another buffer.
+         * A pool that is still being written back is only read again once its write has finished. */
+
+        if (victim->isDirty) {
+            queueCachedPoolWrite(primeList, victim);
+        }
+
+        if (primeList->poolCacheWriteIndex == poolIndex) {
+            waitForPoolWrite(&primeList->poolCacheTransfer);
+        }
+
+        /* A prefetched pool is swapped into the victim.  Either way one buffer is left over as the spare. */
+
+        prefetched = finishPoolRead(&primeList->poolCacheTransfer, &prefetchedIndex);
+        if (prefetched != NULL && prefetchedIndex == poolIndex) {
+            primeList->poolCacheSpare = victim->puddles;
+            victim->puddles           = prefetched;
+        } else {
+            if (prefetched != NULL) {
+                primeList->poolCacheSpare = prefetched;
+            }
+
+            if (victim->puddles == NULL) {
+                victim->puddles = malloc(primeList->configuration.poolSizeInBytes);
+                assert(victim->puddles != NULL);
+            }
+
+            readPoolFile(primeList, poolIndex, victim->puddles);
+        }
+
+        victim->poolIndex = poolIndex;
+        result            = victim;
+
+        /* A sequential scan will want the next pool soon so it is read while the current pool is in use. */
+
+        if (primeList->mappedPoolAdvice == PRIME_LIST_ACCESS_SEQUENTIAL
+            && poolIndex + 1 < primeList->numberPools
+            && findCachedPool(primeList, poolIndex + 1) == NULL) {
+            if (primeList->poolCacheSpare == NULL) {
+                primeList->poolCacheSpare = malloc(primeList->configuration.poolSizeInBytes);
+                assert(primeList->poolCacheSpare != NULL);
+            }
+
+            queuePoolRead(&primeList->poolCacheTransfer, poolIndex + 1, primeList->poolCacheSpare);
+            primeList->poolCacheSpare = NULL;
+        }
+    }
+
+    result->lastUse = ++primeList->poolCacheClock;
+
+    return result;
+}
+
+
+static void checkIfCached(PrimeList* const primeList, unsigned long const newIndex) {
+    if (newIndex != primeList->inMemoryPoolIndex) {
+        flushInMemoryPool(primeList);
+
+        if (primeList->configuration.storage == PRIME_LIST_STORAGE_MEMORY) {
+            ++primeList->poolCacheHits;
+            primeList->inMemoryPool = primeList->residentPools[newIndex];
+        } else if (primeList->configuration.storage == PRIME_LIST_STORAGE_MAPPED) {
+            if (primeList->residentPools[newIndex] == NULL) {
+                primeList->residentPools[newIndex] = mapPoolFile(primeList, newIndex);
+                ++primeList->poolCacheMisses;
+            } else {
+                ++primeList->poolCacheHits;
+            }
+
+            primeList->inMemoryPool = primeList->residentPools[newIndex];
+        } else {
+            primeList->residentEntry = loadCachedPool(primeList, newIndex);
+            primeList->inMemoryPool  = primeList->residentEntry->puddles;
+        }
+
+        primeList->inMemoryPoolIndex = newIndex;
+    }
+}
+
+
+static void const* residentPool(PrimeList* const primeList, unsigned long const poolIndex) {
+    void const* result;
+
+    if (primeList->allPoolsResident) {
+        result = primeList->residentPools[poolIndex];
+    } else {
+        checkIfCached(primeList, poolIndex);
+        result = primeList->inMemoryPool;
+    }
+
+    return result;
+}
+
+
+static void buildPoolRanks(PrimeList* const primeList) {
+    PrimeContainerPoolEntry const* poolTable = primeList->poolTable;
+    unsigned long                  poolIndex;
+    int                            isValid;
+
+    pthread_mutex_lock(&primeList->poolStatisticsLock);
+    isValid = primeList->poolRanksAreValid;
+    pthread_mutex_unlock(&primeList->poolStatisticsLock);
+
+    if (!isValid) {
+        /* Pools that were never written have no summary yet.  Their summaries are computed in memory only. */
+
+        for (poolIndex=0 ; poolIndex<primeList->numberPools ; ++poolIndex) {
+            if (poolTable[poolIndex].numberPrimes == PRIME_CONTAINER_UNKNOWN) {
+                computePoolSummary(primeList, poolIndex, residentPool(primeList, poolIndex));
+            }
+        }
+
+        if (primeList->poolRanks == NULL) {
+            primeList->poolRanks = malloc((primeList->numberPools + 1) * sizeof(uint64_t));
+            assert(primeList->poolRanks != NULL);
+        }
+
+        primeList->poolRanks[0] = 0;
+        for (poolIndex=0 ; poolIndex<primeList->numberPools ; ++poolIndex) {
+            primeList->poolRanks[poolIndex + 1] = primeList->poolRanks[poolIndex] + poolTable[poolIndex].numberPrimes;
+        }
+
+        pthread_mutex_lock(&primeList->poolStatisticsLock);
+        primeList->poolRanksAreValid = 1;
+        pthread_mutex_unlock(&primeList->poolStatisticsLock);
+    }
+}
+
+
+int configurePrimeList(
+        PrimeListConfiguration* const configuration,
+        char const* const             maximumPrime,
+        long const* const             poolSizeInBytes,
+        long const* const             puddleSize,
+        char const* const             filePrefix,
+        char const* const             storage,
+        long const* const             cacheSizeInBytes
+    ) {
+    static char const* const storageNames[] = { "auto", "memory", "pooled", "mapped" };
+
+    int      success = 1;
+    unsigned i;
+
+    configuration->maximumPrime      = MAXIMUM_PRIME;
+    configuration->poolSizeInBytes   = POOL_SIZE_IN_BYTES;
+    configuration->puddleSize        = PUDDLE_SIZE;
+    configuration->filePrefix        = filePrefix != NULL ? filePrefix : PRIME_FILE_PREFIX;
+    configuration->storage           = PRIME_LIST_STORAGE;
+    configuration->cacheSizeInBytes  = POOL_CACHE_SIZE_IN_BYTES;
+    configuration->numberPoolBuffers = 0;
+
+    if (maximumPrime != NULL) {
+        char*              endPointer;
+        unsigned long long value = strtoull(maximumPrime, &endPointer, 0);
+
+        if (*maximumPrime == '\0' || *endPointer != '\0' || value < 3 || value > ((1ULL << 63) - 1)) {
+            fprintf(stderr, "*** Error: Maximum prime must be between 3 and 0x7FFFFFFFFFFFFFFF.\n");
+            success = 0;
+        } else {
+            configuration->maximumPrime = value;
+        }
+    }
+
+    if (poolSizeInBytes != NULL) {
+        /* Every pool occupies at least one alignment unit of the container so smaller pools only waste space.  Larger
+         * pools could hold more primes than a 32-bit rank table entry can count. */
+
+        if (*poolSizeInBytes < PRIME_CONTAINER_POOL_ALIGNMENT
+            || *poolSizeInBytes > PRIME_CONTAINER_MAXIMUM_POOL_SIZE
+            || *poolSizeInBytes % 8 != 0) {
+            fprintf(
+                stderr,
+                "*** Error: Pool size must be a multiple of 8 bytes between %u and %u bytes.\n",
+                PRIME_CONTAINER_POOL_ALIGNMENT,
+                PRIME_CONTAINER_MAXIMUM_POOL_SIZE
+            );
+            success = 0;
+        } else {
+            configuration->poolSizeInBytes = *poolSizeInBytes;
+        }
+    }
+
+    if (puddleSize != NULL) {
+        if (*puddleSize != 32 && *puddleSize != 64) {
+            fprintf(stderr, "*** Error: Puddle size must be 32 or 64.\n");
+            success = 0;
+        } else {
+            configuration->puddleSize = *puddleSize;
+        }
+    }
+
+    if (cacheSizeInBytes != NULL) {
+        if (*cacheSizeInBytes < 0) {
+            fprintf(stderr, "*** Error: Cache size must not be negative.\n");
+            success = 0;
+        } else {
+            configuration->cacheSizeInBytes = *cacheSizeInBytes;
+        }
+    }
 
-    typedef uint32_t PuddleEntry;
+    if (storage != NULL) {
+        for (i=0 ; i<sizeof(storageNames) / sizeof(storageNames[0]) && strcmp(storage, storageNames[i]) != 0 ; ++i) {
+        }
 
-#elif (PUDDLE_SIZE == 64)
+        if (i == sizeof(storageNames) / sizeof(storageNames[0])) {
+            fprintf(stderr, "*** Error: Storage must be auto, memory, pooled, or mapped.\n");
+            success = 0;
+        } else {
+            configuration->storage = (PrimeListStorage) i;
+        }
+    }
 
-    typedef uint64_t PuddleEntry;
+    return success ? 0 : -1;
+}
 
-#else
 
-    #error "Invalid puddle size."
+static PrimeListStorage selectStorage(PrimeList const* const primeList) {
+    PrimeListStorage   result   = primeList->configuration.storage;
+    unsigned long long poolSize = primeList->configuration.poolSizeInBytes;
+    unsigned long long listSize = primeList->numberPools * poolSize;
+
+    /* A list that is being built is held in memory whenever it fits so small runs only write the finished pools.
+     * Pool buffers update such a list in place so they need no memory of their own.  Read-only lists and lists that do
+     * not fit are mapped since the kernel only reads the pages that are touched and can reclaim them under memory
+     * pressure.  Every pool is a separate mapping, so lists with too many pools to map use the pool cache. */
+
+    if (result == PRIME_LIST_STORAGE_AUTOMATIC) {
+        if (primeList->openMode != PRIME_FILE_OPEN_FOR_READING
+            && listSize <= primeList->configuration.cacheSizeInBytes) {
+            result = PRIME_LIST_STORAGE_MEMORY;
+        } else if (primeList->numberPools <= MAXIMUM_AUTOMATIC_MAPPINGS && listSize <= SIZE_MAX / 2) {
+            result = PRIME_LIST_STORAGE_MAPPED;
+        } else {
+            result = PRIME_LIST_STORAGE_POOLED;
+        }
+    }
 
-#endif
+    return result;
+}
+
+
+static int allocateMemoryPools(PrimeList* const primeList) {
+    size_t        poolSize = primeList->configuration.poolSizeInBytes;
+    unsigned long i;
+
+    /* A new container holds no marks so its pools start out zeroed.  Existing pools are read in full. */
 
+    if (primeList->openMode == PRIME_FILE_CREATE_NEW) {
+        primeList->memoryPools = calloc(primeList->numberPools, poolSize);
+    } else {
+        primeList->memoryPools = malloc(primeList->numberPools * poolSize);
+    }
 
-PuddleEntry   inMemoryPool[NUMBER_PUDDLES_PER_POOL];
-unsigned long inMemoryPoolIndex;
-int           inMemoryPoolIsDirty;
-char*         primeFilePrefix;
-char*         primeFilename;
+    if (primeList->memoryPools != NULL) {
+        primeList->memoryPoolIsDirty = calloc(primeList->numberPools, sizeof(unsigned char));
+        assert(primeList->memoryPoolIsDirty != NULL);
 
+        for (i=0 ; i<primeList->numberPools ; ++i) {
+            primeList->residentPools[i] = (unsigned char*) primeList->memoryPools + i * poolSize;
 
-static void flushInMemoryPool(void) {
-    if (inMemoryPoolIsDirty) {
-        int     primeFile;
-        ssize_t bytesWritten;
+            if (primeList->openMode != PRIME_FILE_CREATE_NEW) {
+                readPoolFile(primeList, i, primeList->residentPools[i]);
+            }
+        }
+    }
 
-        sprintf(primeFilename, "%s%05d", primeFilePrefix, inMemoryPoolIndex);
+    return primeList->memoryPools != NULL ? 0 : -1;
+}
 
-        primeFile = open(primeFilename, CREATE_FLAGS, MODES);
-        assert(primeFile >= 0);
 
-        bytesWritten = write(primeFile, inMemoryPool, sizeof(inMemoryPool));
-        assert(bytesWritten == sizeof(inMemoryPool));
+static void releaseContainer(PrimeList* const primeList) {
+    if (primeList->containerFile >= 0) {
+        close(primeList->containerFile);
+        primeList->containerFile = -1;
+    }
 
-        close(primeFile);
+    free(primeList->poolTable);
+    primeList->poolTable = NULL;
 
-        inMemoryPoolIsDirty = 0;
+    if (primeList->rankMapping != NULL) {
+        munmap(primeList->rankMapping, primeList->rankMappingSize);
+        primeList->rankMapping = NULL;
+        primeList->rankTable   = NULL;
     }
+
+    free(primeList->poolRanks);
+    primeList->poolRanks = NULL;
+
+    free(primeList->containerFilename);
+    primeList->containerFilename = NULL;
+
+    free(primeList->filePrefix);
+    primeList->filePrefix = NULL;
 }
 
 
-static void checkIfCached(unsigned long const newIndex) {
-    if (newIndex != inMemoryPoolIndex) {
-        int     primeFile;
-        ssize_t bytesRead;
+PrimeList* createPrimeList(PrimeListConfiguration const* const configuration, PrimeListOpenMode const openMode) {
+    PrimeList*    primeList = malloc(sizeof(PrimeList));
+    unsigned long i;
+
+    assert(primeList != NULL);
+
+    primeList->filePrefix = strdup(configuration->filePrefix);
+    assert(primeList->filePrefix != NULL);
+
+    primeList->containerFilename = malloc(strlen(primeList->filePrefix) + 5);
+    assert(primeList->containerFilename != NULL);
+    sprintf(primeList->containerFilename, "%slist", primeList->filePrefix);
+
+    primeList->configuration            = *configuration;
+    primeList->configuration.filePrefix = primeList->filePrefix;
+    primeList->openMode                 = openMode;
+    primeList->containerFile            = -1;
+    primeList->poolTable                = NULL;
+    primeList->rankTable                = NULL;
+    primeList->rankMapping              = NULL;
+    primeList->poolRanks                = NULL;
+    primeList->poolRanksAreValid        = 0;
+
+    pthread_mutex_init(&primeList->poolStatisticsLock, NULL);
+
+    if (openMode == PRIME_FILE_CREATE_NEW) {
+        assert(configuration->puddleSize == 32 || configuration->puddleSize == 64);
+        assert(configuration->poolSizeInBytes > 0 && configuration->poolSizeInBytes % 8 == 0);
+
+        primeList->bitsPerRankBlock = 8 * (Gf2Polynomial) PRIME_CONTAINER_RANK_BLOCK_SIZE;
+        computeLayout(primeList);
+
+        primeList->poolTable = malloc(primeList->numberPools * sizeof(PrimeContainerPoolEntry));
+        assert(primeList->poolTable != NULL);
+
+        printf("Creating %s\n", primeList->containerFilename);
+    }
+
+    if (openMode == PRIME_FILE_CREATE_NEW ? createContainer(primeList) != 0 : openContainer(primeList, openMode) != 0) {
+        releaseContainer(primeList);
+        pthread_mutex_destroy(&primeList->poolStatisticsLock);
+        free(primeList);
+
+        return NULL;
+    }
+
+    /* The cache holds at least one pool.  Mapped pools rely on the kernel's page cache instead.  When an automatically
+     * selected list does not fit in memory after all, the pool cache is used. */
+
+    primeList->poolCache         = NULL;
+    primeList->poolCacheSize     = 0;
+    primeList->residentPools     = NULL;
+    primeList->allPoolsResident  = 0;
+    primeList->memoryPools       = NULL;
+    primeList->memoryPoolIsDirty = NULL;
+
+    primeList->configuration.storage = selectStorage(primeList);
+
+    if (primeList->configuration.storage != PRIME_LIST_STORAGE_POOLED) {
+        primeList->residentPools = calloc(primeList->numberPools, sizeof(void*));
+        assert(primeList->residentPools != NULL);
+    }
+
+    if (primeList->configuration.storage == PRIME_LIST_STORAGE_MEMORY && allocateMemoryPools(primeList) != 0) {
+        if (configuration->storage != PRIME_LIST_STORAGE_AUTOMATIC) {
+            fprintf(stderr, "*** Error: Unable to hold %lu pools in memory.\n", primeList->numberPools);
+
+            free(primeList->residentPools);
+            releaseContainer(primeList);
+            pthread_mutex_destroy(&primeList->poolStatisticsLock);
+            free(primeList);
+
+            return NULL;
+        }
+
+        primeList->configuration.storage = PRIME_LIST_STORAGE_POOLED;
+    }
+
+    if (primeList->configuration.storage == PRIME_LIST_STORAGE_POOLED) {
+        unsigned long long poolSize      = primeList->configuration.poolSizeInBytes;
+        unsigned long long bufferedBytes = 3 * poolSize * configuration->numberPoolBuffers;
+        unsigned long long cacheBytes    = 0;
+
+        /* Pool buffers copy their pools, so up to three pools per buffer come out of the budget first. */
 
-        flushInMemoryPool();
+        if (configuration->cacheSizeInBytes > bufferedBytes) {
+            cacheBytes = configuration->cacheSizeInBytes - bufferedBytes;
+        }
+
+        primeList->poolCacheSize = cacheBytes / poolSize;
+        if (primeList->poolCacheSize == 0) {
+            primeList->poolCacheSize = 1;
+        } else if (primeList->poolCacheSize > primeList->numberPools) {
+            primeList->poolCacheSize = primeList->numberPools;
+        }
+
+        primeList->poolCache = calloc(primeList->poolCacheSize, sizeof(PoolCacheEntry));
+        assert(primeList->poolCache != NULL);
 
-        sprintf(primeFilename, "%s%05d", primeFilePrefix, newIndex);
+        for (i=0 ; i<primeList->poolCacheSize ; ++i) {
+            primeList->poolCache[i].poolIndex  = (unsigned long) -1;
+            primeList->poolCache[i].dirtyPages = calloc((primeList->numberDirtyPages + 63) / 64, sizeof(uint64_t));
+            assert(primeList->poolCache[i].dirtyPages != NULL);
+        }
+    }
 
-        primeFile = open(primeFilename, OPEN_FLAGS, MODES);
-        assert(primeFile >= 0);
+    primeList->mappedPoolAdvice    = PRIME_LIST_ACCESS_NORMAL;
+    primeList->residentEntry       = NULL;
+    primeList->inMemoryPool        = NULL;
+    primeList->inMemoryPoolIndex   = (unsigned long) -1;
+    primeList->inMemoryPoolIsDirty = 0;
+    primeList->poolCacheClock      = 0;
+    primeList->poolCacheSpare      = NULL;
+    primeList->poolCacheWritePuddles = NULL;
+    primeList->poolCacheWritePages   = NULL;
+    primeList->poolCacheWriteIndex   = (unsigned long) -1;
+    primeList->poolCacheHits       = 0;
+    primeList->poolCacheMisses     = 0;
+    primeList->poolBytesWritten    = 0;
+
+    initializePoolTransfer(primeList, &primeList->poolCacheTransfer);
+
+    if (openMode == PRIME_FILE_OPEN_FOR_READING && primeList->configuration.storage != PRIME_LIST_STORAGE_POOLED) {
+        /* A read only list held in memory or mapped keeps every pool resident until it is destroyed.  Lookups then
+         * never update the handle so any number of threads can share it without locking. */
+
+        if (primeList->configuration.storage == PRIME_LIST_STORAGE_MAPPED) {
+            for (i=0 ; i<primeList->numberPools ; ++i) {
+                primeList->residentPools[i] = mapPoolFile(primeList, i);
+            }
+        }
 
-        bytesRead = read(primeFile, inMemoryPool, sizeof(inMemoryPool));
-        assert(bytesRead == sizeof(inMemoryPool));
+        primeList->allPoolsResident = 1;
+        buildPoolRanks(primeList);
+    } else if (openMode == PRIME_FILE_CREATE_NEW) {
+        /* Every new pool is all zeros so there is no need to read pool 0 back.  Existing containers load their pools
+         * on first use so a reader only pays for the pools it touches. */
 
-        close(primeFile);
+        if (primeList->poolCache != NULL) {
+            primeList->poolCache[0].puddles   = calloc(1, primeList->configuration.poolSizeInBytes);
+            primeList->poolCache[0].poolIndex = 0;
+            assert(primeList->poolCache[0].puddles != NULL);
+        }
 
-        inMemoryPoolIndex = newIndex;
+        checkIfCached(primeList, 0);
     }
+
+    return primeList;
 }
 
 
-void initializePrimeList(char const* const filePrefix, PrimeListOpenMode const openMode) {
-    primeFilePrefix = strdup(filePrefix);
-    assert(primeFilePrefix != NULL);
+void flushPrimeList(PrimeList* const primeList) {
+    /* Pool buffers read the container directly so every change must reach the file.  Releasing the mappings also
+     * updates the pool summaries.  A list whose pools stay resident is read only so there is nothing to write. */
 
-    primeFilename = malloc(strlen(primeFilePrefix)+16);
-    assert(primeFilename != NULL);
+    if (primeList->allPoolsResident) {
+        return;
+    }
 
-    if (openMode == PRIME_FILE_CREATE_NEW) {
+    if (primeList->configuration.storage == PRIME_LIST_STORAGE_MEMORY) {
+        flushInMemoryPool(primeList);
+        writeMemoryPools(primeList);
+    } else if (primeList->configuration.storage == PRIME_LIST_STORAGE_MAPPED) {
+        flushInMemoryPool(primeList);
+        unmapPoolFiles(primeList);
+    } else {
+        flushPoolCache(primeList);
+    }
+}
+
+
+void advisePrimeList(PrimeList* const primeList, PrimeListAccessPattern const accessPattern) {
+    primeList->mappedPoolAdvice = accessPattern;
+
+    if (primeList->configuration.storage == PRIME_LIST_STORAGE_MAPPED) {
         unsigned long poolIndex;
+        size_t        poolSize = primeList->configuration.poolSizeInBytes;
+
+        for (poolIndex=0 ; poolIndex<primeList->numberPools ; ++poolIndex) {
+            if (primeList->residentPools[poolIndex] != NULL) {
+                madvise(primeList->residentPools[poolIndex], poolSize, adviceFlags(accessPattern));
+            }
+        }
+    }
+}
+
+
+void destroyPrimeList(PrimeList* const primeList) {
+    unsigned long i;
+
+    flushPrimeList(primeList);
+
+    if (primeList->allPoolsResident && primeList->configuration.storage == PRIME_LIST_STORAGE_MAPPED) {
+        unmapPoolFiles(primeList);
+    }
+
+    for (i=0 ; i<primeList->poolCacheSize ; ++i) {
+        free(primeList->poolCache[i].puddles);
+        free(primeList->poolCache[i].dirtyPages);
+    }
+
+    free(primeList->poolCache);
+    terminatePoolTransfer(&primeList->poolCacheTransfer);
+    free(primeList->poolCacheSpare);
+    free(primeList->poolCacheWritePuddles);
+    free(primeList->poolCacheWritePages);
+    free(primeList->residentPools);
+    free(primeList->memoryPools);
+    free(primeList->memoryPoolIsDirty);
+
+    releaseContainer(primeList);
+    pthread_mutex_destroy(&primeList->poolStatisticsLock);
+
+    free(primeList);
+}
 
-        memset(inMemoryPool, 0xFF, sizeof(inMemoryPool));
-        inMemoryPoolIndex = 0;
-        inMemoryPoolIsDirty = 0;
 
-        for (poolIndex=0 ; poolIndex < NUMBER_POOLS ; ++poolIndex) {
-            int     primeFile;
-            ssize_t bytesWritten;
+void markComposite(PrimeList* const primeList, Gf2Polynomial const value) {
+    if (value & 1) {
+        Gf2Polynomial bit       = value >> 1;
+        unsigned long poolIndex = bit / primeList->bitsPerPool;
+
+        checkIfCached(primeList, poolIndex);
+
+        if (primeList->configuration.puddleSize == 32) {
+            markPuddleBit(primeList->inMemoryPool, bit % primeList->bitsPerPool, 32);
+        } else {
+            markPuddleBit(primeList->inMemoryPool, bit % primeList->bitsPerPool, 64);
+        }
 
-            sprintf(primeFilename, "%s%05d", primeFilePrefix, poolIndex);
-            printf("Creating %s\n", primeFilename);
+        if (primeList->residentEntry != NULL) {
+            unsigned long page = (bit % primeList->bitsPerPool) / (8 * DIRTY_PAGE_SIZE_IN_BYTES);
+            primeList->residentEntry->dirtyPages[page / 64] |= (uint64_t) 1 << (page % 64);
+        }
+
+        primeList->inMemoryPoolIsDirty = 1;
+    }
+}
 
-            primeFile = open(primeFilename, CREATE_FLAGS, MODES);
-            assert(primeFile >= 0);
 
-            bytesWritten = write(primeFile, inMemoryPool, sizeof(inMemoryPool));
-            assert(bytesWritten == sizeof(inMemoryPool));
+INLINE void markMultiplesInBlock(
+        void* const         puddles,
+        Gf2Polynomial const factor,
+        Gf2Polynomial const blockStart,
+        unsigned const      blockSizeLog2,
+        Gf2Polynomial const poolFirstBit,
+        unsigned const      puddleSize
+    ) {
+    if (gf2Degree(factor) >= blockSizeLog2) {
+        Gf2Polynomial multiple = blockStart ^ gf2Remainder(blockStart, factor);
 
-            close(primeFile);
+        if ((multiple & 1) != 0 && (multiple >> blockSizeLog2) == (blockStart >> blockSizeLog2) && multiple != factor) {
+            markPuddleBit(puddles, (multiple >> 1) - poolFirstBit, puddleSize);
         }
     } else {
-        inMemoryPoolIndex = (unsigned long) -1;
-        inMemoryPoolIsDirty = 0;
+        Gf2MultipleIterator start;
+        Gf2MultipleIterator multiples;
+        Gf2Polynomial       multiple;
+
+        /* Work on a copy whose address never escapes so the stores into the pool can not alias the iterator. */
+
+        gf2MultiplesInBlockStart(&start, factor, blockStart, blockSizeLog2);
+        multiples = start;
+
+        while ((multiple = gf2MultiplesNext(&multiples)) != 0) {
+            if (multiple != factor) {
+                markPuddleBit(puddles, (multiple >> 1) - poolFirstBit, puddleSize);
+            }
+        }
+    }
+}
+
+
+INLINE void markMultiplesInPuddlesOfSize(
+        PrimeList* const    primeList,
+        void* const         puddles,
+        unsigned long const poolIndex,
+        Gf2Polynomial const factor,
+        unsigned const      puddleSize
+    ) {
+    Gf2Polynomial firstValue;
+    Gf2Polynomial lastValue;
+    Gf2Polynomial blockStart;
 
-        checkIfCached(0);
+    assert((factor & 1) != 0);
+
+    primeListPoolBounds(primeList, poolIndex, &firstValue, &lastValue);
+
+    /* Split the pool into the largest aligned power of two blocks that fit.  A full pool is a single block. */
+
+    blockStart = firstValue;
+    while (blockStart <= lastValue) {
+        unsigned blockSizeLog2 = blockStart == 0 ? 63 : countTrailingZeros64(blockStart);
+
+        while (blockSizeLog2 > 0 && (((Gf2Polynomial) 1 << blockSizeLog2) - 1) > lastValue - blockStart) {
+            --blockSizeLog2;
+        }
+
+        markMultiplesInBlock(puddles, factor, blockStart, blockSizeLog2, firstValue >> 1, puddleSize);
+        blockStart += (Gf2Polynomial) 1 << blockSizeLog2;
+
+        if (blockStart == 0) {
+            break;
+        }
     }
 }
 
 
-void terminatePrimeList(void) {
-    int exitStatus;
+static void markMultiplesInPuddles(
+        PrimeList* const    primeList,
+        void* const         puddles,
+        unsigned long const poolIndex,
+        Gf2Polynomial const factor
+    ) {
+    if (primeList->configuration.puddleSize == 32) {
+        markMultiplesInPuddlesOfSize(primeList, puddles, poolIndex, factor, 32);
+    } else {
+        markMultiplesInPuddlesOfSize(primeList, puddles, poolIndex, factor, 64);
+    }
+}
+
 
-    flushInMemoryPool();
+static void* takePoolBufferPuddles(PoolBuffer* const poolBuffer) {
+    void* result;
 
-    free(primeFilePrefix);
-    primeFilePrefix = NULL;
+    if (poolBuffer->numberFreePuddles > 0) {
+        result = poolBuffer->freePuddles[--poolBuffer->numberFreePuddles];
+    } else {
+        result = malloc(poolBuffer->primeList->configuration.poolSizeInBytes);
+        assert(result != NULL);
+    }
 
-    free(primeFilename);
-    primeFilename = NULL;
+    return result;
 }
 
 
-void markComposite(Gf2Polynomial const value) {
-    if (value & 1) {
-        Gf2Polynomial      v           = value >> 1;
-        unsigned long long puddleIndex = v / PUDDLE_SIZE;
-        unsigned           offset      = v % PUDDLE_SIZE;
-        unsigned long      poolIndex   = puddleIndex / NUMBER_PUDDLES_PER_POOL;
-        unsigned long      poolOffset  = puddleIndex % NUMBER_PUDDLES_PER_POOL;
-        PuddleEntry        mask        = ~((PuddleEntry) 1 << offset);
+static void releasePoolBufferPuddles(PoolBuffer* const poolBuffer, void* const puddles) {
+    if (puddles != NULL) {
+        assert(poolBuffer->numberFreePuddles < 3);
+        poolBuffer->freePuddles[poolBuffer->numberFreePuddles++] = puddles;
+    }
+}
+
+
+static void discardPoolBufferPrefetch(PoolBuffer* const poolBuffer) {
+    unsigned long prefetchedIndex;
+    releasePoolBufferPuddles(poolBuffer, finishPoolRead(&poolBuffer->transfer, &prefetchedIndex));
+}
+
 
-        checkIfCached(poolIndex);
-        inMemoryPool[poolOffset] &= mask;
+PoolBuffer* createPoolBuffer(PrimeList* const primeList) {
+    PoolBuffer* poolBuffer = malloc(sizeof(PoolBuffer));
+    assert(poolBuffer != NULL);
 
-        inMemoryPoolIsDirty = 1;
+    poolBuffer->primeList = primeList;
+    poolBuffer->puddles   = NULL;
+
+    if (primeList->configuration.storage != PRIME_LIST_STORAGE_MEMORY) {
+        poolBuffer->puddles = malloc(primeList->configuration.poolSizeInBytes);
+        assert(poolBuffer->puddles != NULL);
     }
+
+    poolBuffer->poolIndex         = (unsigned long) -1;
+    poolBuffer->isDirty           = 0;
+    poolBuffer->writePuddles      = NULL;
+    poolBuffer->numberFreePuddles = 0;
+
+    initializePoolTransfer(primeList, &poolBuffer->transfer);
+
+    return poolBuffer;
 }
 
 
-int isPrime(Gf2Polynomial const value) {
-    if (value & 1) {
-        Gf2Polynomial      v           = value >> 1;
-        unsigned long long puddleIndex = v / PUDDLE_SIZE;
-        unsigned           offset      = v % PUDDLE_SIZE;
-        unsigned long      poolIndex   = puddleIndex / NUMBER_PUDDLES_PER_POOL;
-        unsigned long      poolOffset  = puddleIndex % NUMBER_PUDDLES_PER_POOL;
-        PuddleEntry        mask        = ~((PuddleEntry) 1 << offset);
+void destroyPoolBuffer(PoolBuffer* const poolBuffer) {
+    storePoolBuffer(poolBuffer);
+    discardPoolBufferPrefetch(poolBuffer);
+    terminatePoolTransfer(&poolBuffer->transfer);
+
+    while (poolBuffer->numberFreePuddles > 0) {
+        free(poolBuffer->freePuddles[--poolBuffer->numberFreePuddles]);
+    }
+
+    if (poolBuffer->primeList->configuration.storage != PRIME_LIST_STORAGE_MEMORY) {
+        free(poolBuffer->puddles);
+    }
+
+    free(poolBuffer);
+}
+
+
+void loadPoolBuffer(PoolBuffer* const poolBuffer, unsigned long const poolIndex) {
+    PrimeList*    primeList = poolBuffer->primeList;
+    unsigned long prefetchedIndex;
+    void*         prefetched;
+
+    /* Pools held in memory are updated in place and reach the container when the prime list is flushed. */
+
+    if (primeList->configuration.storage == PRIME_LIST_STORAGE_MEMORY) {
+        storePoolBuffer(poolBuffer);
+
+        poolBuffer->puddles   = primeList->residentPools[poolIndex];
+        poolBuffer->poolIndex = poolIndex;
+
+        return;
+    }
+
+    /* The previous pool is handed to the transfer thread and written back while the new pool is in use. */
+
+    if (poolBuffer->isDirty) {
+        waitForPoolBuffer(poolBuffer);
+        queuePoolWrite(&poolBuffer->transfer, poolBuffer->poolIndex, poolBuffer->puddles, NULL);
+
+        poolBuffer->writePuddles = poolBuffer->puddles;
+        poolBuffer->isDirty      = 0;
+
+        if (poolBuffer->poolIndex == poolIndex) {
+            waitForPoolWrite(&poolBuffer->transfer);
+        }
+    } else {
+        releasePoolBufferPuddles(poolBuffer, poolBuffer->puddles);
+    }
+
+    prefetched = finishPoolRead(&poolBuffer->transfer, &prefetchedIndex);
+    if (prefetched != NULL && prefetchedIndex == poolIndex) {
+        poolBuffer->puddles = prefetched;
+    } else {
+        releasePoolBufferPuddles(poolBuffer, prefetched);
+
+        poolBuffer->puddles = takePoolBufferPuddles(poolBuffer);
+        readPoolFile(primeList, poolIndex, poolBuffer->puddles);
+    }
+
+    poolBuffer->poolIndex = poolIndex;
+}
+
+
+void prefetchPoolBuffer(PoolBuffer* const poolBuffer, unsigned long const poolIndex) {
+    assert(poolIndex != poolBuffer->poolIndex);
+
+    if (poolBuffer->primeList->configuration.storage != PRIME_LIST_STORAGE_MEMORY) {
+        discardPoolBufferPrefetch(poolBuffer);
+        queuePoolRead(&poolBuffer->transfer, poolIndex, takePoolBufferPuddles(poolBuffer));
+    }
+}
+
+
+void waitForPoolBuffer(PoolBuffer* const poolBuffer) {
+    waitForPoolWrite(&poolBuffer->transfer);
+
+    releasePoolBufferPuddles(poolBuffer, poolBuffer->writePuddles);
+    poolBuffer->writePuddles = NULL;
+}
+
+
+void storePoolBuffer(PoolBuffer* const poolBuffer) {
+    waitForPoolBuffer(poolBuffer);
+
+    if (poolBuffer->isDirty) {
+        if (poolBuffer->primeList->configuration.storage == PRIME_LIST_STORAGE_MEMORY) {
+            poolBuffer->primeList->memoryPoolIsDirty[poolBuffer->poolIndex] = 1;
+        } else {
+            writePoolFile(poolBuffer->primeList, poolBuffer->poolIndex, poolBuffer->puddles);
+        }
+
+        poolBuffer->isDirty = 0;
+    }
+}
+
+
+void markMultiplesInPoolBuffer(PoolBuffer* const poolBuffer, Gf2Polynomial const factor) {
+    assert(poolBuffer->poolIndex != (unsigned long) -1);
+
+    markMultiplesInPuddles(poolBuffer->primeList, poolBuffer->puddles, poolBuffer->poolIndex, factor);
+    poolBuffer->isDirty = 1;
+}
+
+
+void markCompositeInPoolBuffer(PoolBuffer* const poolBuffer, Gf2Polynomial const value) {
+    PrimeList const* primeList = poolBuffer->primeList;
+    Gf2Polynomial    bit       = (value >> 1) - (Gf2Polynomial) poolBuffer->poolIndex * primeList->bitsPerPool;
+
+    assert((value & 1) != 0 && bit < primeList->bitsPerPool);
+
+    if (primeList->configuration.puddleSize == 32) {
+        markPuddleBit(poolBuffer->puddles, bit, 32);
+    } else {
+        markPuddleBit(poolBuffer->puddles, bit, 64);
+    }
+
+    poolBuffer->isDirty = 1;
+}
+
+
+void poolBufferBounds(PoolBuffer const* const poolBuffer, Gf2Polynomial* firstValue, Gf2Polynomial* lastValue) {
+    assert(poolBuffer->poolIndex != (unsigned long) -1);
+    primeListPoolBounds(poolBuffer->primeList, poolBuffer->poolIndex, firstValue, lastValue);
+}
+
+
+uint64_t* poolBufferWords(PoolBuffer* const poolBuffer) {
+    assert(poolBuffer->poolIndex != (unsigned long) -1);
+    poolBuffer->isDirty = 1;
+
+    return (uint64_t*) poolBuffer->puddles;
+}
+
+
+Gf2Polynomial primeListMaximumPrime(PrimeList const* const primeList) {
+    return primeList->configuration.maximumPrime;
+}
+
+
+PrimeListStorage primeListStorage(PrimeList const* const primeList) {
+    return primeList->configuration.storage;
+}
+
+
+char const* primeListStorageName(PrimeListStorage const storage) {
+    char const* result;
 
-        checkIfCached(poolIndex);
+    switch (storage) {
+        case PRIME_LIST_STORAGE_AUTOMATIC: { result = "auto";    break; }
+        case PRIME_LIST_STORAGE_MEMORY:    { result = "memory";  break; }
+        case PRIME_LIST_STORAGE_POOLED:    { result = "pooled";  break; }
+        case PRIME_LIST_STORAGE_MAPPED:    { result = "mapped";  break; }
+        default:                           { result = "unknown"; break; }
+    }
+
+    return result;
+}
+
+
+unsigned long primeListNumberPools(PrimeList const* const primeList) {
+    return primeList->numberPools;
+}
+
+
+int primeListPoolSummary(
+        PrimeList const* const      primeList,
+        unsigned long const         poolIndex,
+        PrimeListPoolSummary* const summary
+    ) {
+    PrimeContainerPoolEntry const* entry = primeList->poolTable + poolIndex;
+
+    assert(poolIndex < primeList->numberPools);
+
+    summary->numberPrimes = entry->numberPrimes;
+    summary->firstPrime   = entry->firstPrime;
+    summary->lastPrime    = entry->lastPrime;
+
+    return entry->numberPrimes == PRIME_CONTAINER_UNKNOWN ? -1 : 0;
+}
+
+
+unsigned long long primeListBytesWritten(PrimeList* const primeList) {
+    unsigned long long result;
+
+    pthread_mutex_lock(&primeList->poolStatisticsLock);
+    result = primeList->poolBytesWritten;
+    pthread_mutex_unlock(&primeList->poolStatisticsLock);
+
+    return result;
+}
+
+
+void primeListCacheStatistics(
+        PrimeList const* const    primeList,
+        unsigned long long* const hits,
+        unsigned long long* const misses
+    ) {
+    *hits   = primeList->poolCacheHits;
+    *misses = primeList->poolCacheMisses;
+}
+
+
+void primeListPoolBounds(
+        PrimeList const* const primeList,
+        unsigned long const    poolIndex,
+        Gf2Polynomial*         firstValue,
+        Gf2Polynomial*         lastValue
+    ) {
+    Gf2Polynomial first = 2 * (Gf2Polynomial) poolIndex * primeList->bitsPerPool;
+    Gf2Polynomial last  = first + 2 * primeList->bitsPerPool - 1;
+
+    *firstValue = first;
+    *lastValue  = last > primeList->configuration.maximumPrime ? primeList->configuration.maximumPrime : last;
+}
+
+
+unsigned long primeListPoolIndex(PrimeList const* const primeList, Gf2Polynomial const value) {
+    assert(value <= primeList->configuration.maximumPrime);
+    return (value >> 1) / primeList->bitsPerPool;
+}
+
+
+uint64_t const* primeListPoolWords(PrimeList* const primeList, unsigned long const poolIndex) {
+    assert(poolIndex < primeList->numberPools);
+    return (uint64_t const*) residentPool(primeList, poolIndex);
+}
 
-        return (inMemoryPool[poolOffset] & mask) != 0;
+
+int isPrime(PrimeList* const primeList, Gf2Polynomial const value) {
+    if ((value & 1) && value <= primeList->configuration.maximumPrime) {
+        Gf2Polynomial bit       = value >> 1;
+        unsigned long poolIndex = bit / primeList->bitsPerPool;
+        void const*   puddles   = residentPool(primeList, poolIndex);
+
+        if (primeList->configuration.puddleSize == 32) {
+            return !testPuddleBit(puddles, bit % primeList->bitsPerPool, 32);
+        } else {
+            return !testPuddleBit(puddles, bit % primeList->bitsPerPool, 64);
+        }
     } else {
         return 0;
     }
 }
 
 
-Gf2Polynomial findNextPrime(Gf2Polynomial const currentPrime) {
-    Gf2Polynomial      cp          = currentPrime >> 1;
-    unsigned long long puddleIndex = (cp+1) / PUDDLE_SIZE;
-    unsigned long      poolIndex   = puddleIndex / NUMBER_PUDDLES_PER_POOL;
-    unsigned long      poolOffset  = puddleIndex % NUMBER_PUDDLES_PER_POOL;
-    Gf2Polynomial      result      = 0;
+Gf2Polynomial findNextPrime(PrimeList* const primeList, Gf2Polynomial const currentPrime) {
+    Gf2Polynomial numberBits  = primeList->numberBits;
+    Gf2Polynomial bitsPerPool = primeList->bitsPerPool;
+    Gf2Polynomial bit         = (currentPrime + 1) >> 1;
+    Gf2Polynomial result      = 0;
+
+    /* Marks only ever add composites so a stored summary still bounds the primes of its pool.  The search starts at
+     * the pool's first prime and pools holding no primes past the current bit are skipped without being read. */
+
+    while (result == 0 && bit < numberBits) {
+        unsigned long                  poolIndex    = bit / bitsPerPool;
+        Gf2Polynomial                  poolFirstBit = poolIndex * bitsPerPool;
+        Gf2Polynomial                  endBit       = numberBits - poolFirstBit < bitsPerPool
+                                                      ? numberBits - poolFirstBit
+                                                      : bitsPerPool;
+        PrimeContainerPoolEntry const* entry        = primeList->poolTable + poolIndex;
+        int                            isKnown      = entry->numberPrimes != PRIME_CONTAINER_UNKNOWN;
+
+        if (isKnown && bit < (entry->firstPrime >> 1)) {
+            bit = entry->firstPrime >> 1;
+        }
+
+        if (isKnown && (entry->numberPrimes == 0 || bit > (entry->lastPrime >> 1))) {
+            bit = poolFirstBit + endBit;
+        } else {
+            void const*   puddles = residentPool(primeList, poolIndex);
+            Gf2Polynomial found;
+
+            if (primeList->configuration.puddleSize == 32) {
+                found = findClearPuddleBit(puddles, bit - poolFirstBit, endBit, 32);
+            } else {
+                found = findClearPuddleBit(puddles, bit - poolFirstBit, endBit, 64);
+            }
+
+            if (found < endBit) {
+                result = 2 * (poolFirstBit + found) + 1;
+            } else {
+                bit = poolFirstBit + endBit;
+            }
+        }
+    }
+
+    return result;
+}
+
+
+unsigned long long countPrimesUpTo(PrimeList* const primeList, Gf2Polynomial const value) {
+    unsigned long long result = 0;
+
+    if (value >= 2) {
+        Gf2Polynomial maximumPrime = primeList->configuration.maximumPrime;
+        Gf2Polynomial endBit       = ((value < maximumPrime ? value : maximumPrime) + 1) / 2;
+        unsigned long poolIndex    = endBit / primeList->bitsPerPool;
 
-    if (puddleIndex < NUMBER_PUDDLES) {
-        unsigned        offset = (cp+1) % PUDDLE_SIZE;
-        PuddleEntry     mask   = ((PuddleEntry) -1) << offset;
-        PuddleEntry     entry;
+        buildPoolRanks(primeList);
 
-        checkIfCached(poolIndex);
-        entry = inMemoryPool[poolOffset] & mask;
+        /* The value 2 is prime but is not tracked by the pools. */
 
-        if (entry == 0) {
-            do {
-                do {
-                    ++poolOffset;
-                    if (poolOffset < NUMBER_PUDDLES_PER_POOL) {
-                        entry = inMemoryPool[poolOffset];
-                    }
-                } while (poolOffset < NUMBER_PUDDLES_PER_POOL && entry == 0);
+        result = 1 + primeList->poolRanks[poolIndex];
 
-                if (poolOffset >= NUMBER_PUDDLES_PER_POOL) {
-                    ++poolIndex;
-                    poolOffset = 0;
+        if (poolIndex < primeList->numberPools) {
+            Gf2Polynomial bit        = endBit % primeList->bitsPerPool;
+            unsigned long blockIndex = bit / primeList->bitsPerRankBlock;
+            Gf2Polynomial word       = blockIndex * primeList->bitsPerRankBlock / 64;
 
-                    if (poolIndex < NUMBER_POOLS) {
-                        checkIfCached(poolIndex);
-                        entry = inMemoryPool[0];
-                    }
+            result += primeList->rankTable[poolIndex * primeList->numberRankBlocks + blockIndex];
+
+            if (bit % primeList->bitsPerRankBlock != 0) {
+                uint64_t const* words = (uint64_t const*) residentPool(primeList, poolIndex);
+
+                while (word < bit / 64) {
+                    result += countOnes64(~words[word]);
+                    ++word;
+                }
+
+                if (bit % 64 != 0) {
+                    result += countOnes64(~words[word] & (((uint64_t) 1 << (bit % 64)) - 1));
                 }
-            } while (poolIndex < NUMBER_POOLS && entry == 0);
+            }
         }
+    }
+
+    return result;
+}
 
-        if (poolIndex < NUMBER_POOLS) {
-            #if (PUDDLE_SIZE == 32)
 
-                offset = countTrailingZeros32(entry);
+Gf2Polynomial nthPrime(PrimeList* const primeList, unsigned long long const n) {
+    Gf2Polynomial result = 0;
+
+    if (n == 1) {
+        result = 2;
+    } else if (n > 1) {
+        unsigned long long rank = n - 2;
+
+        buildPoolRanks(primeList);
+
+        if (rank < primeList->poolRanks[primeList->numberPools]) {
+            unsigned long   low  = 0;
+            unsigned long   high = primeList->numberPools;
+            unsigned long   poolIndex;
+            uint32_t const* ranks;
+            uint64_t const* words;
+            Gf2Polynomial   word;
+            uint64_t        candidates;
+
+            /* Find the last pool and then the last block that start at or before the requested rank. */
+
+            while (high - low > 1) {
+                unsigned long middle = low + (high - low) / 2;
+
+                if (primeList->poolRanks[middle] <= rank) {
+                    low = middle;
+                } else {
+                    high = middle;
+                }
+            }
+
+            poolIndex  = low;
+            rank      -= primeList->poolRanks[poolIndex];
+            ranks      = primeList->rankTable + poolIndex * primeList->numberRankBlocks;
+            words      = (uint64_t const*) residentPool(primeList, poolIndex);
+
+            high = primeList->numberRankBlocks;
+            low  = 0;
+            while (high - low > 1) {
+                unsigned long middle = low + (high - low) / 2;
+
+                if (ranks[middle] <= rank) {
+                    low = middle;
+                } else {
+                    high = middle;
+                }
+            }
 
-            #else
+            rank       -= ranks[low];
+            word        = low * primeList->bitsPerRankBlock / 64;
+            candidates  = ~words[word];
 
-                offset = countTrailingZeros64(entry);
+            while (countOnes64(candidates) <= rank) {
+                rank       -= countOnes64(candidates);
+                candidates  = ~words[++word];
+            }
 
-            #endif
+            while (rank > 0) {
+                candidates &= candidates - 1;
+                --rank;
+            }
 
-            result = 2 * (((NUMBER_PUDDLES_PER_POOL * poolIndex) + poolOffset) * PUDDLE_SIZE + offset) + 1;
+            result = 2 * (poolIndex * primeList->bitsPerPool + word * 64 + countTrailingZeros64(candidates)) + 1;
         }
     }
 
@@ -20,66 +20,567 @@
 #ifndef PRIME_LIST_H
 #define PRIME_LIST_H
 
+#include <stdint.h>
+
 #include "gf2.h"
 
+/*******************************************************************************************************************//**
+* \brief Specifies where the pools of a prime list are held while the list is open.
+*
+* You can use this enumeration to select how a prime list reaches its pools.  PRIME_LIST_STORAGE_MEMORY holds every pool
+* in memory and only writes the pools to the container when the list is flushed.  PRIME_LIST_STORAGE_POOLED holds the
+* most recently used pools in a cache, reads whole pools, and writes evicted pools back in the background.
+* PRIME_LIST_STORAGE_MAPPED memory maps the pools in the container.  PRIME_LIST_STORAGE_AUTOMATIC selects
+* PRIME_LIST_STORAGE_MEMORY when a list that is created or updated fits in the memory budget.  Read-only lists and lists
+* that do not fit are memory mapped unless they hold too many pools to map, in which case PRIME_LIST_STORAGE_POOLED is
+* selected.  The storage does not change the container format.
+***********************************************************************************************************************/
+typedef enum PrimeListStorage {
+    PRIME_LIST_STORAGE_AUTOMATIC,
+    PRIME_LIST_STORAGE_MEMORY,
+    PRIME_LIST_STORAGE_POOLED,
+    PRIME_LIST_STORAGE_MAPPED
+} PrimeListStorage;
+
+/*******************************************************************************************************************//**
+* \brief Describes the layout of a prime list.
+*
+* You can use this structure to specify the range of values tracked by a prime list and how the list is stored.  The
+* maximum prime, pool size, and puddle size are recorded in the container when it is created.  Readers take those
+* settings from the container.
+***********************************************************************************************************************/
+typedef struct PrimeListConfiguration {
+    /**
+     * The largest value tracked by the prime list.
+     */
+    Gf2Polynomial maximumPrime;
+
+    /**
+     * The size of each pool, in bytes.  The value must be a multiple of 8.
+     */
+    unsigned long poolSizeInBytes;
+
+    /**
+     * The width, in bits, of the words used to access a pool.  The value must be 32 or 64.
+     */
+    unsigned puddleSize;
+
+    /**
+     * The prefix used to name the container file.
+     */
+    char const* filePrefix;
+
+    /**
+     * Where the pools are held while the list is open.
+     */
+    PrimeListStorage storage;
+
+    /**
+     * The memory budget, in bytes, for the pools held in memory, including the pools held by pool buffers.  The budget
+     * decides whether automatic storage can hold every pool in memory and sizes the pool cache of pooled storage.  At
+     * least one pool is always cached.
+     */
+    unsigned long cacheSizeInBytes;
+
+    /**
+     * The number of pool buffers that will be in use at the same time.  Each pool buffer may hold up to three pools
+     * unless every pool is held in memory, so the pool cache is reduced to keep those pools within the budget.
+     */
+    unsigned long numberPoolBuffers;
+} PrimeListConfiguration;
 
 /*******************************************************************************************************************//**
 * \brief Specifies how the prime file should be opened.
 *
-* You can use this enumeration to clearly specify how the prime file should be opened.
+* You can use this enumeration to clearly specify how the prime file should be opened.  Use
+* PRIME_FILE_OPEN_FOR_UPDATE to continue updating the container left by an earlier run without recreating it.
 ***********************************************************************************************************************/
 typedef enum PrimeListOpenMode {
     PRIME_FILE_CREATE_NEW,
-    PRIME_FILE_OPEN_FOR_READING
+    PRIME_FILE_OPEN_FOR_READING,
+    PRIME_FILE_OPEN_FOR_UPDATE
 } PrimeListOpenMode;
 
 /*******************************************************************************************************************//**
-* \brief Initializes the prime list.
+* \brief Specifies how the prime list is about to be accessed.
+*
+* You can use this enumeration to tell the prime list whether upcoming accesses will walk the values in order, as
+* \ref findNextPrime does, or jump between distant values, as \ref markComposite does for large primes.
+***********************************************************************************************************************/
+typedef enum PrimeListAccessPattern {
+    PRIME_LIST_ACCESS_NORMAL,
+    PRIME_LIST_ACCESS_SEQUENTIAL,
+    PRIME_LIST_ACCESS_RANDOM
+} PrimeListAccessPattern;
+
+/*******************************************************************************************************************//**
+* \brief Handle referencing an open prime list.
+*
+* You can use a prime list handle to access one container.  Handles are independent of each other so several prime
+* lists can be open in the same process.  A handle should only be used by one thread at a time.  The exception is a
+* handle opened with PRIME_FILE_OPEN_FOR_READING using memory or mapped storage.  Such a handle reads or maps every pool
+* when it is created and is never modified afterwards, so \ref isPrime, \ref findNextPrime, \ref countPrimesUpTo, and
+* \ref nthPrime can be called on it from any number of threads without locking.
+***********************************************************************************************************************/
+typedef struct PrimeList PrimeList;
+
+/*******************************************************************************************************************//**
+* \brief Private buffer holding a single pool.
+*
+* You can use a pool buffer to load, update, and store a pool independently of the prime list's shared resident pool.
+* Each thread should use its own pool buffer and no two pool buffers should hold the same pool at the same time.  A pool
+* buffer owns a background thread that writes back the previous pool and reads ahead the next pool, so a pool buffer
+* may hold up to three pools in memory.  When the prime list holds every pool in memory, a pool buffer updates the
+* pool in place and needs no memory or thread of its own.
+***********************************************************************************************************************/
+typedef struct PoolBuffer PoolBuffer;
+
+/*******************************************************************************************************************//**
+* \brief Builds a prime list configuration from optional settings.
+*
+* You can use this function to combine the settings supplied on the command line with the defaults in parameters.h.
+* Any setting passed as NULL takes its default value.  An error message is written to stderr if a setting is invalid.
+*
+* \param[out] configuration    The configuration to populate.  The file prefix references either filePrefix or the
+*                              default prefix.
+*
+* \param[in]  maximumPrime     The maximum prime, in decimal, octal or hexadecimal notation.
+*
+* \param[in]  poolSizeInBytes  The pool size in bytes.
+*
+* \param[in]  puddleSize       The puddle size in bits.
+*
+* \param[in]  filePrefix       The prefix used to name the container file.
 *
-* You can use this function to initialize the prime list.
+* \param[in]  storage          The storage, one of auto, memory, pooled, or mapped.
 *
-* \param[in] filePrefix A prefix to assign to the prime list files.
+* \param[in]  cacheSizeInBytes The memory budget for the pools held in memory, in bytes.
 *
-* \param[in] openMode You can use this define to specify how the prime file should be opened.
+* \return Returns 0 on success.  Returns -1 if a setting is invalid.
 ***********************************************************************************************************************/
-void initializePrimeList(char const* const filePrefix, PrimeListOpenMode const openMode);
+GF2PRIMES_API int configurePrimeList(
+    PrimeListConfiguration* const configuration,
+    char const* const             maximumPrime,
+    long const* const             poolSizeInBytes,
+    long const* const             puddleSize,
+    char const* const             filePrefix,
+    char const* const             storage,
+    long const* const             cacheSizeInBytes
+);
 
 /*******************************************************************************************************************//**
-* \brief Cleans up the generated prime list.
+* \brief Opens a prime list.
 *
-* You can use this function to do any clean-up to get the prime list coherent when the application terminates.
+* You can use this function to open a prime list.  The prime list is held in a single container file named by
+* appending "list" to the file prefix.  An error message is written to stderr if an existing container can not be
+* opened or does not match the configuration.  Automatic storage is resolved once the number of pools is known.
+* Unless every pool is held in memory, pools of an existing container are not read until they are first accessed.
+*
+* \param[in] configuration The layout of the prime list.  The configuration is copied.  When reading, the maximum prime,
+*                          pool size, and puddle size are taken from the container instead.
+*
+* \param[in] openMode      You can use this define to specify how the prime file should be opened.
+*
+* \return Returns a handle to the prime list.  Returns NULL if the container could not be opened.
 ***********************************************************************************************************************/
-void terminatePrimeList(void);
+GF2PRIMES_API PrimeList* createPrimeList(
+    PrimeListConfiguration const* const configuration,
+    PrimeListOpenMode const             openMode
+);
+
+/*******************************************************************************************************************//**
+* \brief Closes a prime list.
+*
+* You can use this function to make the container coherent and release every resource held by a prime list.  Every
+* pool buffer created from the prime list must be destroyed first.
+*
+* \param[in] primeList The prime list to close.
+***********************************************************************************************************************/
+GF2PRIMES_API void destroyPrimeList(PrimeList* const primeList);
+
+/*******************************************************************************************************************//**
+* \brief Writes the shared resident pool back to disk and releases it.
+*
+* You can use this function to make the container coherent before it is accessed through \ref PoolBuffer instances.
+* The next access through \ref markComposite, \ref isPrime, or \ref findNextPrime reloads the pool.  When the pools
+* are memory mapped, the modified pages are written back and every mapping is released.  When every pool is held in
+* memory, the modified pools are written and stay in memory.  Read-only handles that read or map every pool up front
+* are left untouched.
+*
+* \param[in] primeList The prime list to flush.
+***********************************************************************************************************************/
+GF2PRIMES_API void flushPrimeList(PrimeList* const primeList);
+
+/*******************************************************************************************************************//**
+* \brief Describes how the shared resident pool is about to be accessed.
+*
+* You can use this function to let the kernel tune read-ahead for memory mapped pools.  The advice applies to every
+* pool mapped now or later.  When the pools are not memory mapped, sequential access makes the pool cache read the
+* next pool in the background whenever it loads a pool.
+*
+* \param[in] primeList     The prime list to advise.
+*
+* \param[in] accessPattern The expected access pattern.
+***********************************************************************************************************************/
+GF2PRIMES_API void advisePrimeList(PrimeList* const primeList, PrimeListAccessPattern const accessPattern);
 
 /*******************************************************************************************************************//**
 * \brief Marks a value as composite (not prime).
 *
 * You can use this function to mark an entry as a composite value.
 *
-* \param[in] value The value to mark as a composite value.
+* \param[in] primeList The prime list to update.
+*
+* \param[in] value     The value to mark as a composite value.
+***********************************************************************************************************************/
+GF2PRIMES_API void markComposite(PrimeList* const primeList, Gf2Polynomial const value);
+
+/*******************************************************************************************************************//**
+* \brief Allocates a pool buffer.
+*
+* You can use this function to allocate a private buffer large enough to hold one pool of a prime list.  The prime
+* list must outlive the pool buffer.
+*
+* \param[in] primeList The prime list whose pools will be held by the buffer.
+*
+* \return Returns a pointer to the newly allocated pool buffer.  The buffer initially holds no pool.
+***********************************************************************************************************************/
+GF2PRIMES_API PoolBuffer* createPoolBuffer(PrimeList* const primeList);
+
+/*******************************************************************************************************************//**
+* \brief Releases a pool buffer.
+*
+* You can use this function to release a pool buffer.  Any changes held by the buffer are written back first.
+*
+* \param[in] poolBuffer The pool buffer to release.
+***********************************************************************************************************************/
+GF2PRIMES_API void destroyPoolBuffer(PoolBuffer* const poolBuffer);
+
+/*******************************************************************************************************************//**
+* \brief Loads a pool into a pool buffer.
+*
+* You can use this function to read a pool into a pool buffer.  Any changes to the pool previously held by the buffer
+* are written back in the background.  Use \ref waitForPoolBuffer or \ref storePoolBuffer to wait until the previous
+* pool is on disk.  If the pool was requested through \ref prefetchPoolBuffer, the prefetched copy is used.
+*
+* \param[in,out] poolBuffer The pool buffer to load.
+*
+* \param[in]     poolIndex  The zero based index of the pool to load.
+***********************************************************************************************************************/
+GF2PRIMES_API void loadPoolBuffer(PoolBuffer* const poolBuffer, unsigned long const poolIndex);
+
+/*******************************************************************************************************************//**
+* \brief Starts reading a pool in the background.
+*
+* You can use this function to read the pool that will be loaded next while the current pool is being updated.  A
+* later call to \ref loadPoolBuffer for the same pool waits for the read and then uses it.  Any earlier prefetch is
+* discarded.
+*
+* \param[in,out] poolBuffer The pool buffer that will load the pool.
+*
+* \param[in]     poolIndex  The zero based index of the pool to read.  The pool must not be the pool currently held by
+*                           the buffer.
+***********************************************************************************************************************/
+GF2PRIMES_API void prefetchPoolBuffer(PoolBuffer* const poolBuffer, unsigned long const poolIndex);
+
+/*******************************************************************************************************************//**
+* \brief Waits for background writes from a pool buffer.
+*
+* You can use this function to make sure every pool handed off by \ref loadPoolBuffer has been written back.  The pool
+* currently held by the buffer is not written.
+*
+* \param[in,out] poolBuffer The pool buffer to wait on.
+***********************************************************************************************************************/
+GF2PRIMES_API void waitForPoolBuffer(PoolBuffer* const poolBuffer);
+
+/*******************************************************************************************************************//**
+* \brief Writes a pool buffer back to disk.
+*
+* You can use this function to write any changes held by a pool buffer back to the container.  Background writes of
+* earlier pools are completed first.  When the prime list holds every pool in memory, the pool is only recorded as
+* modified and is written when the prime list is flushed.
+*
+* \param[in,out] poolBuffer The pool buffer to write.
+***********************************************************************************************************************/
+GF2PRIMES_API void storePoolBuffer(PoolBuffer* const poolBuffer);
+
+/*******************************************************************************************************************//**
+* \brief Marks every multiple of a polynomial inside a pool buffer as composite.
+*
+* You can use this function to apply a sieving prime to the pool held by a pool buffer.  Every odd multiple of the
+* factor that falls inside the pool, other than the factor itself, is marked composite.
+*
+* \param[in,out] poolBuffer The pool buffer to update.  A pool must be loaded.
+*
+* \param[in]     factor     The odd polynomial whose multiples should be marked.
+***********************************************************************************************************************/
+GF2PRIMES_API void markMultiplesInPoolBuffer(PoolBuffer* const poolBuffer, Gf2Polynomial const factor);
+
+/*******************************************************************************************************************//**
+* \brief Marks a single value held by a pool buffer as composite.
+*
+* You can use this function to mark one value inside the pool currently held by a pool buffer.
+*
+* \param[in,out] poolBuffer The pool buffer to update.  A pool must be loaded.
+*
+* \param[in]     value      The odd value to mark.  The value must lie inside the loaded pool.
+***********************************************************************************************************************/
+GF2PRIMES_API void markCompositeInPoolBuffer(PoolBuffer* const poolBuffer, Gf2Polynomial const value);
+
+/*******************************************************************************************************************//**
+* \brief Determines the range of values covered by the pool held by a pool buffer.
+*
+* You can use this function to determine the first and last values tracked by the most recently loaded pool.
+*
+* \param[in]  poolBuffer The pool buffer to query.
+*
+* \param[out] firstValue The first value tracked by the pool.
+*
+* \param[out] lastValue  The last value tracked by the pool.  The value is clamped to the maximum prime.
+***********************************************************************************************************************/
+GF2PRIMES_API void poolBufferBounds(
+    PoolBuffer const* const poolBuffer,
+    Gf2Polynomial*          firstValue,
+    Gf2Polynomial*          lastValue
+);
+
+/*******************************************************************************************************************//**
+* \brief Provides direct access to the words held by a pool buffer.
+*
+* You can use this function to update a loaded pool in bulk.  Bit i of the pool, counting from the least significant
+* bit of the first word, tracks the odd value 2 * i + 1 offset by the first value of the pool.  The bit is set once the
+* value is known to be composite.  On little endian hosts the layout does not depend on the puddle size.  The pool
+* buffer is assumed to be modified by the caller.
+*
+* \param[in,out] poolBuffer The pool buffer to access.  A pool must be loaded.
+*
+* \return Returns a pointer to the first 64-bit word of the loaded pool.
+***********************************************************************************************************************/
+GF2PRIMES_API uint64_t* poolBufferWords(PoolBuffer* const poolBuffer);
+
+/*******************************************************************************************************************//**
+* \brief Determines the maximum prime tracked by the prime list.
+*
+* \param[in] primeList The prime list to query.
+*
+* \return Returns the maximum prime from the prime list configuration.
+***********************************************************************************************************************/
+GF2PRIMES_API Gf2Polynomial primeListMaximumPrime(PrimeList const* const primeList);
+
+/*******************************************************************************************************************//**
+* \brief Determines the number of pools used to hold the prime list.
+*
+* You can use this function to determine how many pools are needed to cover every value up to the maximum prime.
+*
+* \param[in] primeList The prime list to query.
+*
+* \return Returns the number of pools.
+***********************************************************************************************************************/
+GF2PRIMES_API unsigned long primeListNumberPools(PrimeList const* const primeList);
+
+/*******************************************************************************************************************//**
+* \brief Determines where the pools of a prime list are held.
+*
+* You can use this function to learn which storage was selected when the prime list was opened with automatic storage.
+*
+* \param[in] primeList The prime list to query.
+*
+* \return Returns the storage in use.  The value is never PRIME_LIST_STORAGE_AUTOMATIC.
 ***********************************************************************************************************************/
-void markComposite(Gf2Polynomial const value);
+GF2PRIMES_API PrimeListStorage primeListStorage(PrimeList const* const primeList);
+
+/*******************************************************************************************************************//**
+* \brief Names a prime list storage.
+*
+* You can use this function to report the storage in use.  The names match those accepted by
+* \ref configurePrimeList.
+*
+* \param[in] storage The storage to name.
+*
+* \return Returns the storage name.
+***********************************************************************************************************************/
+GF2PRIMES_API char const* primeListStorageName(PrimeListStorage const storage);
+
+/*******************************************************************************************************************//**
+* \brief Summary of the primes held by a single pool.
+*
+* You can use this structure to count or locate primes without reading the pool itself.
+***********************************************************************************************************************/
+typedef struct PrimeListPoolSummary {
+    /**
+     * The number of primes in the pool.
+     */
+    unsigned long long numberPrimes;
+
+    /**
+     * The first prime in the pool or 0 if the pool holds no primes.
+     */
+    Gf2Polynomial firstPrime;
+
+    /**
+     * The last prime in the pool or 0 if the pool holds no primes.
+     */
+    Gf2Polynomial lastPrime;
+} PrimeListPoolSummary;
+
+/*******************************************************************************************************************//**
+* \brief Reads the summary stored in the container for a pool.
+*
+* You can use this function to obtain the prime count and the first and last prime of a pool.  Summaries are updated
+* each time a pool is written to the container.  The value 2 is never counted since only odd values are tracked.  Marks
+* only add composites, so a summary stays a valid bound on the primes of its pool after later marks.
+*
+* \param[in]  primeList The prime list to query.
+*
+* \param[in]  poolIndex The zero based index of the pool.
+*
+* \param[out] summary   The summary of the pool.
+*
+* \return Returns 0 on success.  Returns -1 if the pool has not been summarized yet.
+***********************************************************************************************************************/
+GF2PRIMES_API int primeListPoolSummary(
+    PrimeList const* const      primeList,
+    unsigned long const         poolIndex,
+    PrimeListPoolSummary* const summary
+);
+
+/*******************************************************************************************************************//**
+* \brief Reports how much pool data has been written to disk.
+*
+* You can use this function to measure the write traffic of a run.  The shared resident pools track which pages were
+* modified and only write those pages back.  Pool buffers write whole pools.  Pages written back by the kernel for
+* memory mapped pools are not counted.
+*
+* \param[in] primeList The prime list to query.
+*
+* \return Returns the number of bytes of pool data written to the container since the prime list was opened.
+***********************************************************************************************************************/
+GF2PRIMES_API unsigned long long primeListBytesWritten(PrimeList* const primeList);
+
+/*******************************************************************************************************************//**
+* \brief Reports how well the pool cache is working.
+*
+* You can use this function to size the pool cache for a host.  Only switches between pools are counted, repeated
+* accesses to the most recently used pool are not.  A hit is a switch to a pool that was still cached or mapped.  A miss
+* is a switch that had to read or map a pool.
+*
+* \param[in]  primeList The prime list to query.
+*
+* \param[out] hits      The number of cache hits since the prime list was opened.
+*
+* \param[out] misses    The number of cache misses since the prime list was opened.
+***********************************************************************************************************************/
+GF2PRIMES_API void primeListCacheStatistics(
+    PrimeList const* const    primeList,
+    unsigned long long* const hits,
+    unsigned long long* const misses
+);
+
+/*******************************************************************************************************************//**
+* \brief Determines the range of values covered by a pool.
+*
+* You can use this function to determine the first and last values tracked by a pool.
+*
+* \param[in]  primeList  The prime list to query.
+*
+* \param[in]  poolIndex  The zero based index of the pool.
+*
+* \param[out] firstValue The first value tracked by the pool.
+*
+* \param[out] lastValue  The last value tracked by the pool.  The value is clamped to the maximum prime.
+***********************************************************************************************************************/
+GF2PRIMES_API void primeListPoolBounds(
+    PrimeList const* const primeList,
+    unsigned long const    poolIndex,
+    Gf2Polynomial*         firstValue,
+    Gf2Polynomial*         lastValue
+);
+
+/*******************************************************************************************************************//**
+* \brief Determines which pool tracks a value.
+*
+* You can use this function to locate the pools that overlap a range of values without loading any of them.
+*
+* \param[in] primeList The prime list to query.
+*
+* \param[in] value     The value to locate.  The value must not exceed the maximum prime.
+*
+* \return Returns the zero based index of the pool tracking the value.
+***********************************************************************************************************************/
+GF2PRIMES_API unsigned long primeListPoolIndex(PrimeList const* const primeList, Gf2Polynomial const value);
+
+/*******************************************************************************************************************//**
+* \brief Provides read-only access to the words of a pool.
+*
+* You can use this function to scan a pool in bulk rather than one prime at a time.  The layout matches
+* \ref poolBufferWords.  The pool is made resident the same way \ref isPrime would, so the pointer is only valid until
+* the next call that accesses a different pool.  Read-only handles that keep every pool mapped return pointers that
+* remain valid until the handle is destroyed.
+*
+* \param[in] primeList The prime list to access.
+*
+* \param[in] poolIndex The zero based index of the pool.
+*
+* \return Returns a pointer to the first 64-bit word of the pool.  Bits past the maximum prime are undefined.
+***********************************************************************************************************************/
+GF2PRIMES_API uint64_t const* primeListPoolWords(PrimeList* const primeList, unsigned long const poolIndex);
 
 /*******************************************************************************************************************//**
 * \brief Determines if a value is prime.
 *
 * You can use this function to determine if a specified value is prime.
 *
-* \param[in] value The value to be checked.
+* \param[in] primeList The prime list to query.
+*
+* \param[in] value     The value to be checked.
 *
 * \return Returns 0 if the value is composite.  Returns a non-zero result if the value is prime.
 ***********************************************************************************************************************/
-int isPrime(Gf2Polynomial const value);
+GF2PRIMES_API int isPrime(PrimeList* const primeList, Gf2Polynomial const value);
 
 /*******************************************************************************************************************//**
 * \brief Locates the next known prime value.
 *
-* You can use this function to quickly locate the next prime value in the prime list.
+* You can use this function to quickly locate the next prime value in the prime list.  Pools whose summary shows no
+* primes past the current value are skipped without being read.
+*
+* \param[in] primeList    The prime list to query.
 *
 * \param[in] currentPrime The current value.  The function will find the next prime after this value.
 *
 * \return Returns the next known prime.  A value of 0 is returned if no new prime could be located.
 ***********************************************************************************************************************/
-Gf2Polynomial findNextPrime(Gf2Polynomial const currentPrime);
+GF2PRIMES_API Gf2Polynomial findNextPrime(PrimeList* const primeList, Gf2Polynomial const currentPrime);
+
+/*******************************************************************************************************************//**
+* \brief Counts the primes up to a value.
+*
+* You can use this function to count the irreducible polynomials that do not exceed a value without walking the list.
+* The count is built from the pool summaries and the rank table so at most one rank block of one pool is read.  The
+* rank table is memory mapped so only the rank blocks of the pools that are queried are ever read from the container.
+* The index reflects the pools written to the container, call \ref flushPrimeList first if the list was modified.
+*
+* \param[in] primeList The prime list to query.
+*
+* \param[in] value     The largest value to include.  Values past the maximum prime are clamped to the maximum prime.
+*
+* \return Returns the number of primes less than or equal to the value, including 2.
+***********************************************************************************************************************/
+GF2PRIMES_API unsigned long long countPrimesUpTo(PrimeList* const primeList, Gf2Polynomial const value);
+
+/*******************************************************************************************************************//**
+* \brief Locates a prime by its position in the list.
+*
+* You can use this function to find the nth irreducible polynomial without walking the list.  The pool and rank block
+* holding the prime are located by binary search so at most one rank block of one pool is scanned.  The index
+* reflects the pools written to the container, call \ref flushPrimeList first if the list was modified.
+*
+* \param[in] primeList The prime list to query.
+*
+* \param[in] n         The one based position of the prime.  A value of 1 selects 2.
+*
+* \return Returns the nth prime.  A value of 0 is returned if n is 0 or the list holds fewer than n primes.
+***********************************************************************************************************************/
+GF2PRIMES_API Gf2Polynomial nthPrime(PrimeList* const primeList, unsigned long long const n);
 
 #endif
@@ -0,0 +1,372 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Buffered output of prime lists.
+*
+* This file implements the buffered output used to write large numbers of primes without going through stdio.
+***********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <unistd.h>
+#include <errno.h>
+
+#include "compiler.h"
+#include "gf2.h"
+#include "prime_format.h"
+#include "prime_output.h"
+
+
+/* The buffer is flushed whenever a whole word of primes might not fit. */
+
+#define MAXIMUM_WORD_OUTPUT_SIZE (64 * PRIME_FORMAT_MAXIMUM_SIZE)
+#define MINIMUM_BUFFER_SIZE (4096)
+
+#define HEX_PAIRS(high) \
+    high "0" high "1" high "2" high "3" high "4" high "5" high "6" high "7" \
+    high "8" high "9" high "a" high "b" high "c" high "d" high "e" high "f"
+
+
+struct PrimeOutput {
+    int           fileDescriptor;
+    PrimeFormat   format;
+    Gf2Polynomial previousPrime;
+    char*         buffer;
+    size_t        bufferSize;
+    size_t        used;
+    int           failed;
+};
+
+
+/* Entry 2 * b and 2 * b + 1 hold the two lower case hexadecimal digits of the byte b. */
+
+static char const hexPairs[] =
+    HEX_PAIRS("0") HEX_PAIRS("1") HEX_PAIRS("2") HEX_PAIRS("3")
+    HEX_PAIRS("4") HEX_PAIRS("5") HEX_PAIRS("6") HEX_PAIRS("7")
+    HEX_PAIRS("8") HEX_PAIRS("9") HEX_PAIRS("a") HEX_PAIRS("b")
+    HEX_PAIRS("c") HEX_PAIRS("d") HEX_PAIRS("e") HEX_PAIRS("f");
+
+
+static void writeBytes(PrimeOutput* const primeOutput, char const* bytes, size_t remaining) {
+    while (remaining > 0 && !primeOutput->failed) {
+        ssize_t bytesWritten = write(primeOutput->fileDescriptor, bytes, remaining);
+
+        if (bytesWritten > 0) {
+            bytes     += bytesWritten;
+            remaining -= bytesWritten;
+        } else if (bytesWritten < 0 && errno != EINTR) {
+            fprintf(stderr, "*** Error: Could not write the prime list: %s.\n", strerror(errno));
+            primeOutput->failed = 1;
+        }
+    }
+}
+
+
+static void makeRoom(PrimeOutput* const primeOutput, size_t const size) {
+    /* Buffered primes are written out to make room.  A prime output without a file descriptor grows instead. */
+
+    if (primeOutput->fileDescriptor >= 0) {
+        writeBytes(primeOutput, primeOutput->buffer, primeOutput->used);
+        primeOutput->used = 0;
+    }
+
+    if (primeOutput->bufferSize - primeOutput->used < size) {
+        while (primeOutput->bufferSize - primeOutput->used < size) {
+            primeOutput->bufferSize *= 2;
+        }
+
+        primeOutput->buffer = realloc(primeOutput->buffer, primeOutput->bufferSize);
+        assert(primeOutput->buffer != NULL);
+    }
+}
+
+
+INLINE char* formatHex(char* const cursor, Gf2Polynomial value) {
+    unsigned numberDigits = (67 - countLeadingZeros64(value)) / 4;
+    char*    end          = cursor + numberDigits;
+    char*    digit        = end;
+
+    /* The digits are written two at a time from the least significant end.  The output matches printf's "%" PRIx64
+     * conversion. */
+
+    while (value >= 0x100) {
+        digit -= 2;
+        memcpy(digit, hexPairs + 2 * (value & 0xFF), 2);
+        value >>= 8;
+    }
+
+    if (value >= 0x10) {
+        memcpy(digit - 2, hexPairs + 2 * value, 2);
+    } else {
+        digit[-1] = hexPairs[2 * value + 1];
+    }
+
+    *end = '\n';
+
+    return end + 1;
+}
+
+
+INLINE char* formatU64le(char* const cursor, Gf2Polynomial const value) {
+    unsigned i;
+
+    /* Written a byte at a time so the output does not depend on the host byte order.  The compiler merges the bytes
+     * into a single store on little endian hosts. */
+
+    for (i=0 ; i<8 ; ++i) {
+        cursor[i] = (char) (value >> (8 * i));
+    }
+
+    return cursor + 8;
+}
+
+
+INLINE char* formatVarint(char* cursor, Gf2Polynomial value) {
+    while (value >= 0x80) {
+        *cursor++ = (char) (value | 0x80);
+        value >>= 7;
+    }
+
+    *cursor++ = (char) value;
+
+    return cursor;
+}
+
+
+INLINE char* formatPrime(
+        char* const          cursor,
+        Gf2Polynomial const  prime,
+        Gf2Polynomial* const previousPrime,
+        PrimeFormat const    format
+    ) {
+    char* result;
+
+    switch (format) {
+        case PRIME_FORMAT_U64LE: {
+            result = formatU64le(cursor, prime);
+            break;
+        }
+
+        case PRIME_FORMAT_DELTA_VARINT: {
+            result         = formatVarint(cursor, prime - *previousPrime);
+            *previousPrime = prime;
+            break;
+        }
+
+        default: {
+            result = formatHex(cursor, prime);
+            break;
+        }
+    }
+
+    return result;
+}
+
+
+INLINE char* writeWordsInFormat(
+        PrimeOutput* const    primeOutput,
+        char*                 cursor,
+        uint64_t const* const words,
+        uint64_t const        firstBit,
+        uint64_t const        endBit,
+        Gf2Polynomial const   firstValue,
+        PrimeFormat const     format
+    ) {
+    uint64_t      firstWord     = firstBit / 64;
+    uint64_t      endWord       = (endBit + 63) / 64;
+    char*         limit         = primeOutput->buffer + primeOutput->bufferSize - MAXIMUM_WORD_OUTPUT_SIZE;
+    Gf2Polynomial previousPrime = primeOutput->previousPrime;
+    uint64_t      i;
+
+    for (i=firstWord ; i<endWord ; ++i) {
+        uint64_t      candidates = ~words[i];
+        Gf2Polynomial wordValue  = firstValue + 128 * i;
+
+        if (i == firstWord) {
+            candidates &= ~(uint64_t) 0 << (firstBit % 64);
+        }
+
+        if (i == endWord - 1 && endBit % 64 != 0) {
+            candidates &= ((uint64_t) 1 << (endBit % 64)) - 1;
+        }
+
+        if (cursor > limit) {
+            primeOutput->used = cursor - primeOutput->buffer;
+            makeRoom(primeOutput, MAXIMUM_WORD_OUTPUT_SIZE);
+
+            cursor = primeOutput->buffer + primeOutput->used;
+            limit  = primeOutput->buffer + primeOutput->bufferSize - MAXIMUM_WORD_OUTPUT_SIZE;
+        }
+
+        while (candidates != 0) {
+            Gf2Polynomial prime = wordValue + 2 * countTrailingZeros64(candidates);
+
+            cursor      = formatPrime(cursor, prime, &previousPrime, format);
+            candidates &= candidates - 1;
+        }
+    }
+
+    primeOutput->previousPrime = previousPrime;
+
+    return cursor;
+}
+
+
+PrimeOutput* createPrimeOutput(int const fileDescriptor, PrimeFormat const format, size_t const bufferSizeInBytes) {
+    PrimeOutput* primeOutput = malloc(sizeof(PrimeOutput));
+
+    assert(primeOutput != NULL);
+    assert(bufferSizeInBytes >= MINIMUM_BUFFER_SIZE);
+
+    primeOutput->fileDescriptor = fileDescriptor;
+    primeOutput->format         = format;
+    primeOutput->previousPrime  = 0;
+    primeOutput->buffer         = malloc(bufferSizeInBytes);
+    primeOutput->bufferSize     = bufferSizeInBytes;
+    primeOutput->used           = 0;
+    primeOutput->failed         = 0;
+    assert(primeOutput->buffer != NULL);
+
+    return primeOutput;
+}
+
+
+void writePrime(PrimeOutput* const primeOutput, Gf2Polynomial const prime) {
+    char* cursor;
+
+    if (primeOutput->used + PRIME_FORMAT_MAXIMUM_SIZE > primeOutput->bufferSize) {
+        makeRoom(primeOutput, PRIME_FORMAT_MAXIMUM_SIZE);
+    }
+
+    cursor            = primeOutput->buffer + primeOutput->used;
+    cursor            = formatPrime(cursor, prime, &primeOutput->previousPrime, primeOutput->format);
+    primeOutput->used = cursor - primeOutput->buffer;
+}
+
+
+void writePoolPrimes(
+        PrimeOutput* const    primeOutput,
+        uint64_t const* const words,
+        uint64_t const        firstBit,
+        uint64_t const        endBit,
+        Gf2Polynomial const   firstValue
+    ) {
+    char* cursor = primeOutput->buffer + primeOutput->used;
+
+    /* Each format gets its own copy of the scan so the format is not tested for every prime. */
+
+    switch (primeOutput->format) {
+        case PRIME_FORMAT_U64LE: {
+            cursor = writeWordsInFormat(primeOutput, cursor, words, firstBit, endBit, firstValue, PRIME_FORMAT_U64LE);
+            break;
+        }
+
+        case PRIME_FORMAT_DELTA_VARINT: {
+            cursor = writeWordsInFormat(
+                primeOutput,
+                cursor,
+                words,
+                firstBit,
+                endBit,
+                firstValue,
+                PRIME_FORMAT_DELTA_VARINT
+            );
+
+            break;
+        }
+
+        default: {
+            cursor = writeWordsInFormat(primeOutput, cursor, words, firstBit, endBit, firstValue, PRIME_FORMAT_HEX);
+            break;
+        }
+    }
+
+    primeOutput->used = cursor - primeOutput->buffer;
+}
+
+
+void appendPrimeOutput(PrimeOutput* const destination, PrimeOutput* const source) {
+    char const* bytes = source->buffer;
+    size_t      size  = source->used;
+
+    assert(destination->format == source->format);
+
+    if (size > 0) {
+        if (source->format == PRIME_FORMAT_DELTA_VARINT) {
+            Gf2Polynomial firstPrime = 0;
+            unsigned      shift      = 0;
+            char*         cursor;
+
+            /* The first prime of the source was encoded relative to 0.  It is encoded again relative to the last
+             * prime written to the destination. */
+
+            do {
+                firstPrime |= (Gf2Polynomial) (*bytes & 0x7F) << shift;
+                shift      += 7;
+            } while (*bytes++ & 0x80);
+
+            size -= bytes - source->buffer;
+
+            if (destination->used + PRIME_FORMAT_MAXIMUM_SIZE > destination->bufferSize) {
+                makeRoom(destination, PRIME_FORMAT_MAXIMUM_SIZE);
+            }
+
+            cursor            = destination->buffer + destination->used;
+            cursor            = formatVarint(cursor, firstPrime - destination->previousPrime);
+            destination->used = cursor - destination->buffer;
+        }
+
+        /* Large blocks bypass the destination's buffer. */
+
+        if (destination->used + size > destination->bufferSize) {
+            if (destination->fileDescriptor >= 0 && size >= destination->bufferSize / 2) {
+                makeRoom(destination, 0);
+                writeBytes(destination, bytes, size);
+                size = 0;
+            } else {
+                makeRoom(destination, size);
+            }
+        }
+
+        memcpy(destination->buffer + destination->used, bytes, size);
+        destination->used          += size;
+        destination->previousPrime  = source->previousPrime;
+    }
+
+    source->used          = 0;
+    source->previousPrime = 0;
+}
+
+
+int flushPrimeOutput(PrimeOutput* const primeOutput) {
+    if (primeOutput->fileDescriptor >= 0) {
+        makeRoom(primeOutput, 0);
+    }
+
+    return primeOutput->failed ? -1 : 0;
+}
+
+
+int destroyPrimeOutput(PrimeOutput* const primeOutput) {
+    int result = flushPrimeOutput(primeOutput);
+
+    free(primeOutput->buffer);
+    free(primeOutput);
+
+    return result;
+}
@@ -0,0 +1,133 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Buffered output of prime lists.
+*
+* This file defines functions used to write large numbers of primes without going through stdio.  Primes are found by
+* scanning whole pool words for clear bits and are encoded, in one of the formats defined in prime_format.h, into a
+* large buffer that is handed to the kernel with a few large write calls.
+***********************************************************************************************************************/
+
+#ifndef PRIME_OUTPUT_H
+#define PRIME_OUTPUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gf2.h"
+#include "prime_format.h"
+
+/*******************************************************************************************************************//**
+* \brief Opaque prime output state.
+*
+* You can use this type to accumulate formatted primes before they are written to a file descriptor.  A prime output
+* should only be used by one thread at a time.
+***********************************************************************************************************************/
+typedef struct PrimeOutput PrimeOutput;
+
+/*******************************************************************************************************************//**
+* \brief Creates a prime output.
+*
+* You can use this function to start writing primes to a file descriptor.  The file descriptor is not closed when the
+* prime output is destroyed.  A prime output created without a file descriptor keeps every prime in memory, growing its
+* buffer as needed, until the primes are moved to another prime output by \ref appendPrimeOutput.
+*
+* \param[in] fileDescriptor    The file descriptor to write to.  A negative value keeps the primes in memory.
+*
+* \param[in] format            The format used to encode the primes.
+*
+* \param[in] bufferSizeInBytes The size of the output buffer.  The value must be at least 4 KBytes.
+*
+* \return Returns a newly allocated prime output.
+***********************************************************************************************************************/
+GF2PRIMES_API PrimeOutput* createPrimeOutput(
+    int const         fileDescriptor,
+    PrimeFormat const format,
+    size_t const      bufferSizeInBytes
+);
+
+/*******************************************************************************************************************//**
+* \brief Writes a single prime.
+*
+* You can use this function to write a prime that is not tracked by a pool, such as 2.  Primes must be written in
+* ascending order.
+*
+* \param[in,out] primeOutput The prime output to update.
+*
+* \param[in]     prime       The prime to write.
+***********************************************************************************************************************/
+GF2PRIMES_API void writePrime(PrimeOutput* const primeOutput, Gf2Polynomial const prime);
+
+/*******************************************************************************************************************//**
+* \brief Writes every prime held by a range of pool bits.
+*
+* You can use this function to write the primes tracked by part of a pool, as returned by \ref primeListPoolWords, in
+* ascending order.  Bit i of the words tracks the value firstValue + 2 * i.  A clear bit marks a prime.
+*
+* \param[in,out] primeOutput The prime output to update.
+*
+* \param[in]     words       The words to scan.
+*
+* \param[in]     firstBit    The first bit to scan.
+*
+* \param[in]     endBit      One past the last bit to scan.
+*
+* \param[in]     firstValue  The odd value tracked by bit 0 of the first word.
+***********************************************************************************************************************/
+GF2PRIMES_API void writePoolPrimes(
+    PrimeOutput* const    primeOutput,
+    uint64_t const* const words,
+    uint64_t const        firstBit,
+    uint64_t const        endBit,
+    Gf2Polynomial const   firstValue
+);
+
+/*******************************************************************************************************************//**
+* \brief Moves the primes held by one prime output to the end of another.
+*
+* You can use this function to format disjoint ranges of primes in parallel and then emit them in order.  Each range is
+* written to its own in-memory prime output, starting from an empty prime output, and the ranges are then appended to
+* the final prime output in ascending order.  The result is identical to writing every prime to the final prime output
+* directly, including the differences stored by PRIME_FORMAT_DELTA_VARINT.
+*
+* \param[in,out] destination The prime output receiving the primes.
+*
+* \param[in,out] source      The in-memory prime output holding the primes.  The prime output is left empty.  Both
+*                            prime outputs must use the same format.
+***********************************************************************************************************************/
+GF2PRIMES_API void appendPrimeOutput(PrimeOutput* const destination, PrimeOutput* const source);
+
+/*******************************************************************************************************************//**
+* \brief Writes any buffered primes to the file descriptor.
+*
+* You can use this function to push buffered primes out before the prime output is destroyed.  An error message is
+* written to stderr the first time a write fails.  Later writes are discarded.  Prime outputs without a file descriptor
+* are left unchanged.
+*
+* \param[in,out] primeOutput The prime output to flush.
+*
+* \return Returns 0 on success.  Returns -1 if any write has failed.
+***********************************************************************************************************************/
+GF2PRIMES_API int flushPrimeOutput(PrimeOutput* const primeOutput);
+
+/*******************************************************************************************************************//**
+* \brief Flushes and releases a prime output.
+*
+* \param[in] primeOutput The prime output to be released.
+*
+* \return Returns 0 on success.  Returns -1 if any write has failed.
+***********************************************************************************************************************/
+GF2PRIMES_API int destroyPrimeOutput(PrimeOutput* const primeOutput);
+
+#endif
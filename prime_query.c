@@ -0,0 +1,285 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Support shared by prime_server_gf2 and its clients.
+*
+* This file implements the query evaluation, latency counters, and socket helpers used on both ends of the prime query
+* protocol.
+***********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "compiler.h"
+#include "gf2.h"
+#include "prime_list.h"
+#include "prime_query.h"
+
+
+static double bucketUpperBoundInMicroseconds(QueryStatistics const* const statistics, double const fraction) {
+    unsigned long long threshold = (unsigned long long) (fraction * statistics->numberBatches);
+    unsigned long long seen      = 0;
+    unsigned           bucket    = 0;
+
+    while (bucket < QUERY_STATISTICS_NUMBER_BUCKETS - 1 && seen + statistics->latencyHistogram[bucket] <= threshold) {
+        seen += statistics->latencyHistogram[bucket];
+        ++bucket;
+    }
+
+    return 2.0 * (double) ((unsigned long long) 1 << bucket) / 1000.0;
+}
+
+
+static void answerPrimeQuery(
+        PrimeList* const               primeList,
+        Gf2Polynomial const            maximumPrime,
+        PrimeQueryRequest const* const request,
+        PrimeQueryResponse* const      response
+    ) {
+    Gf2Polynomial argument = request->argument;
+    Gf2Polynomial result   = 0;
+    uint32_t      status   = PRIME_QUERY_OK;
+
+    /* The pools only track odd values so 2 is answered here. */
+
+    switch (request->operation) {
+        case PRIME_QUERY_IS_PRIME: {
+            if (argument > maximumPrime) {
+                status = PRIME_QUERY_OUT_OF_RANGE;
+            } else {
+                result = argument == 2 || isPrime(primeList, argument) ? 1 : 0;
+            }
+
+            break;
+        }
+
+        case PRIME_QUERY_NEXT_PRIME: {
+            if (argument < 2) {
+                result = 2;
+            } else if (argument < maximumPrime) {
+                result = findNextPrime(primeList, argument);
+            }
+
+            if (result == 0) {
+                status = PRIME_QUERY_OUT_OF_RANGE;
+            }
+
+            break;
+        }
+
+        case PRIME_QUERY_RANK: {
+            if (argument > maximumPrime) {
+                status = PRIME_QUERY_OUT_OF_RANGE;
+            } else {
+                result = countPrimesUpTo(primeList, argument);
+            }
+
+            break;
+        }
+
+        case PRIME_QUERY_NTH: {
+            result = nthPrime(primeList, argument);
+            if (result == 0) {
+                status = PRIME_QUERY_OUT_OF_RANGE;
+            }
+
+            break;
+        }
+
+        case PRIME_QUERY_MAXIMUM_PRIME: {
+            result = maximumPrime;
+            break;
+        }
+
+        default: {
+            status = PRIME_QUERY_UNKNOWN_OPERATION;
+            break;
+        }
+    }
+
+    response->tag    = request->tag;
+    response->status = status;
+    response->result = result;
+}
+
+
+void answerPrimeQueries(
+        PrimeList* const               primeList,
+        PrimeQueryRequest const* const requests,
+        PrimeQueryResponse* const      responses,
+        unsigned long const            numberRequests
+    ) {
+    Gf2Polynomial maximumPrime = primeListMaximumPrime(primeList);
+    unsigned long i;
+
+    for (i=0 ; i<numberRequests ; ++i) {
+        answerPrimeQuery(primeList, maximumPrime, requests + i, responses + i);
+    }
+}
+
+
+unsigned long long monotonicNanoseconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return 1000000000ULL * now.tv_sec + now.tv_nsec;
+}
+
+
+void initializeQueryStatistics(QueryStatistics* const statistics) {
+    memset(statistics, 0, sizeof(QueryStatistics));
+}
+
+
+void recordQueryLatency(
+        QueryStatistics* const   statistics,
+        unsigned long const      numberRequests,
+        unsigned long long const latencyInNanoseconds
+    ) {
+    unsigned bucket = latencyInNanoseconds == 0 ? 0 : 63 - countLeadingZeros64(latencyInNanoseconds);
+
+    statistics->numberRequests            += numberRequests;
+    statistics->numberBatches             += 1;
+    statistics->totalLatencyInNanoseconds += latencyInNanoseconds;
+    statistics->latencyHistogram[bucket]  += 1;
+
+    if (latencyInNanoseconds > statistics->maximumLatencyInNanoseconds) {
+        statistics->maximumLatencyInNanoseconds = latencyInNanoseconds;
+    }
+}
+
+
+void mergeQueryStatistics(QueryStatistics* const destination, QueryStatistics const* const source) {
+    unsigned bucket;
+
+    destination->numberRequests            += source->numberRequests;
+    destination->numberBatches             += source->numberBatches;
+    destination->totalLatencyInNanoseconds += source->totalLatencyInNanoseconds;
+
+    if (source->maximumLatencyInNanoseconds > destination->maximumLatencyInNanoseconds) {
+        destination->maximumLatencyInNanoseconds = source->maximumLatencyInNanoseconds;
+    }
+
+    for (bucket=0 ; bucket<QUERY_STATISTICS_NUMBER_BUCKETS ; ++bucket) {
+        destination->latencyHistogram[bucket] += source->latencyHistogram[bucket];
+    }
+}
+
+
+void reportQueryStatistics(
+        FILE*                        file,
+        char const*                  label,
+        QueryStatistics const* const statistics,
+        double const                 elapsedSeconds
+    ) {
+    if (statistics->numberBatches == 0) {
+        fprintf(file, "%s: No requests in %.1f seconds.\n", label, elapsedSeconds);
+    } else {
+        fprintf(
+            file,
+            "%s: %llu requests in %llu batches over %.1f seconds, %.0f requests/second, batch latency mean %.1f us, "
+            "p50 < %.1f us, p99 < %.1f us, maximum %.1f us.\n",
+            label,
+            statistics->numberRequests,
+            statistics->numberBatches,
+            elapsedSeconds,
+            elapsedSeconds > 0 ? statistics->numberRequests / elapsedSeconds : 0.0,
+            statistics->totalLatencyInNanoseconds / 1000.0 / statistics->numberBatches,
+            bucketUpperBoundInMicroseconds(statistics, 0.50),
+            bucketUpperBoundInMicroseconds(statistics, 0.99),
+            statistics->maximumLatencyInNanoseconds / 1000.0
+        );
+    }
+
+    fflush(file);
+}
+
+
+int connectToPrimeServer(char const* const socketPath) {
+    struct sockaddr_un address;
+    int                fileDescriptor;
+
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "*** Error: The socket path \"%s\" is too long.\n", socketPath);
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    fileDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fileDescriptor < 0) {
+        fprintf(stderr, "*** Error: Could not create a socket: %s.\n", strerror(errno));
+        return -1;
+    }
+
+    if (connect(fileDescriptor, (struct sockaddr const*) &address, sizeof(address)) != 0) {
+        fprintf(stderr, "*** Error: Could not connect to \"%s\": %s.\n", socketPath, strerror(errno));
+        close(fileDescriptor);
+
+        return -1;
+    }
+
+    return fileDescriptor;
+}
+
+
+int sendQueryBytes(int const fileDescriptor, void const* const bytes, size_t const size) {
+    char const* cursor    = (char const*) bytes;
+    size_t      remaining = size;
+
+    /* MSG_NOSIGNAL reports a closed peer as EPIPE rather than raising SIGPIPE. */
+
+    while (remaining > 0) {
+        ssize_t bytesWritten = send(fileDescriptor, cursor, remaining, MSG_NOSIGNAL);
+
+        if (bytesWritten > 0) {
+            cursor    += bytesWritten;
+            remaining -= bytesWritten;
+        } else if (bytesWritten < 0 && errno != EINTR) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+int receiveQueryBytes(int const fileDescriptor, void* const bytes, size_t const size) {
+    char*  cursor    = (char*) bytes;
+    size_t remaining = size;
+
+    while (remaining > 0) {
+        ssize_t bytesRead = read(fileDescriptor, cursor, remaining);
+
+        if (bytesRead > 0) {
+            cursor    += bytesRead;
+            remaining -= bytesRead;
+        } else if (bytesRead == 0 || errno != EINTR) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,252 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Binary protocol spoken by prime_server_gf2.
+*
+* This file defines the messages exchanged with prime_server_gf2 over a Unix domain socket.  A client writes a stream of
+* fixed size \ref PrimeQueryRequest records and the server answers with one \ref PrimeQueryResponse per request, in
+* the order the requests were received.  Clients may write any number of requests before reading the responses so
+* requests can be batched and pipelined freely.  The tag of each request is copied into its response.
+*
+* Every field is stored in host byte order since both ends run on the same host.  The file also declares the socket and
+* latency helpers shared by the server and its clients, and \ref answerPrimeQueries, which answers an array of requests
+* directly against a prime list so programs linking the library can batch queries without running the server.
+***********************************************************************************************************************/
+
+#ifndef PRIME_QUERY_H
+#define PRIME_QUERY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "compiler.h"
+#include "gf2.h"
+#include "prime_list.h"
+
+/*******************************************************************************************************************//**
+* \brief The queries answered by the server.
+*
+* You can use this enumeration to select the operation performed for a request.
+*
+* * PRIME_QUERY_IS_PRIME returns 1 if the argument is prime and 0 otherwise.
+* * PRIME_QUERY_NEXT_PRIME returns the first prime greater than the argument.
+* * PRIME_QUERY_RANK returns the number of primes less than or equal to the argument, including 2.
+* * PRIME_QUERY_NTH returns the prime at the one based position given by the argument.
+* * PRIME_QUERY_MAXIMUM_PRIME returns the largest value tracked by the server's prime list.  The argument is ignored.
+***********************************************************************************************************************/
+typedef enum PrimeQueryOperation {
+    PRIME_QUERY_IS_PRIME = 1,
+    PRIME_QUERY_NEXT_PRIME = 2,
+    PRIME_QUERY_RANK = 3,
+    PRIME_QUERY_NTH = 4,
+    PRIME_QUERY_MAXIMUM_PRIME = 5
+} PrimeQueryOperation;
+
+/*******************************************************************************************************************//**
+* \brief The status returned with each response.
+*
+* You can use this enumeration to determine if a response holds a result.  PRIME_QUERY_OUT_OF_RANGE is returned when
+* the answer lies past the values tracked by the prime list, for example the next prime after the last prime.
+***********************************************************************************************************************/
+typedef enum PrimeQueryStatus {
+    PRIME_QUERY_OK = 0,
+    PRIME_QUERY_OUT_OF_RANGE = 1,
+    PRIME_QUERY_UNKNOWN_OPERATION = 2
+} PrimeQueryStatus;
+
+/*******************************************************************************************************************//**
+* \brief A single query sent to the server.
+***********************************************************************************************************************/
+typedef struct PrimeQueryRequest {
+    /**
+     * Holds a value chosen by the client.  The value is copied into the response.
+     */
+    uint32_t tag;
+
+    /**
+     * Holds a \ref PrimeQueryOperation value.
+     */
+    uint32_t operation;
+
+    /**
+     * Holds the value or position the query applies to.
+     */
+    uint64_t argument;
+} PrimeQueryRequest;
+
+/*******************************************************************************************************************//**
+* \brief The answer to a single query.
+***********************************************************************************************************************/
+typedef struct PrimeQueryResponse {
+    /**
+     * Holds the tag of the request.
+     */
+    uint32_t tag;
+
+    /**
+     * Holds a \ref PrimeQueryStatus value.
+     */
+    uint32_t status;
+
+    /**
+     * Holds the result of the query.  The value is 0 if the status is not PRIME_QUERY_OK.
+     */
+    uint64_t result;
+} PrimeQueryResponse;
+
+/*******************************************************************************************************************//**
+* \brief The number of buckets in a latency histogram.
+***********************************************************************************************************************/
+#define QUERY_STATISTICS_NUMBER_BUCKETS (64)
+
+/*******************************************************************************************************************//**
+* \brief Throughput and latency counters.
+*
+* You can use this structure to accumulate the latency of batches of requests.  Bucket b of the histogram counts the
+* batches that took from 2^b up to 2^(b+1) nanoseconds, bucket 0 also counts batches that took no measurable time.
+***********************************************************************************************************************/
+typedef struct QueryStatistics {
+    unsigned long long numberRequests;
+    unsigned long long numberBatches;
+    unsigned long long totalLatencyInNanoseconds;
+    unsigned long long maximumLatencyInNanoseconds;
+    unsigned long long latencyHistogram[QUERY_STATISTICS_NUMBER_BUCKETS];
+} QueryStatistics;
+
+/*******************************************************************************************************************//**
+* \brief Answers an array of queries.
+*
+* You can use this function to evaluate a batch of requests against a prime list, as prime_server_gf2 does for each
+* read.  Response i answers request i.  Several threads may call this function on the same read-only prime list opened
+* with memory or mapped storage since such a handle is never modified after it is created.
+*
+* \param[in]  primeList      The prime list to query.
+*
+* \param[in]  requests       The requests to answer.
+*
+* \param[out] responses      The array receiving one response per request.
+*
+* \param[in]  numberRequests The number of requests.
+***********************************************************************************************************************/
+GF2PRIMES_API void answerPrimeQueries(
+    PrimeList* const               primeList,
+    PrimeQueryRequest const* const requests,
+    PrimeQueryResponse* const      responses,
+    unsigned long const            numberRequests
+);
+
+/*******************************************************************************************************************//**
+* \brief Reads a monotonic clock.
+*
+* \return Returns the current time, in nanoseconds, relative to an arbitrary starting point.
+***********************************************************************************************************************/
+GF2PRIMES_API unsigned long long monotonicNanoseconds(void);
+
+/*******************************************************************************************************************//**
+* \brief Clears a set of counters.
+*
+* \param[out] statistics The counters to clear.
+***********************************************************************************************************************/
+GF2PRIMES_API void initializeQueryStatistics(QueryStatistics* const statistics);
+
+/*******************************************************************************************************************//**
+* \brief Records the latency of a batch of requests.
+*
+* \param[in,out] statistics            The counters to update.
+*
+* \param[in]     numberRequests        The number of requests in the batch.
+*
+* \param[in]     latencyInNanoseconds  The time taken by the batch.
+***********************************************************************************************************************/
+GF2PRIMES_API void recordQueryLatency(
+    QueryStatistics* const   statistics,
+    unsigned long const      numberRequests,
+    unsigned long long const latencyInNanoseconds
+);
+
+/*******************************************************************************************************************//**
+* \brief Adds one set of counters to another.
+*
+* \param[in,out] destination The counters to update.
+*
+* \param[in]     source      The counters to add.
+***********************************************************************************************************************/
+GF2PRIMES_API void mergeQueryStatistics(QueryStatistics* const destination, QueryStatistics const* const source);
+
+/*******************************************************************************************************************//**
+* \brief Writes a one line summary of a set of counters.
+*
+* You can use this function to report the throughput and the mean, median, 99th percentile, and maximum batch latency.
+* Percentiles are reported as the upper bound of the histogram bucket holding them.
+*
+* \param[in] file           The file to write to.
+*
+* \param[in] label          Text written at the start of the line.
+*
+* \param[in] statistics     The counters to report.
+*
+* \param[in] elapsedSeconds The time over which the counters were accumulated.
+***********************************************************************************************************************/
+GF2PRIMES_API void reportQueryStatistics(
+    FILE*                        file,
+    char const*                  label,
+    QueryStatistics const* const statistics,
+    double const                 elapsedSeconds
+);
+
+/*******************************************************************************************************************//**
+* \brief Connects to a query server.
+*
+* You can use this function to open a connection to prime_server_gf2.  An error message is written to stderr if the
+* connection can not be made.
+*
+* \param[in] socketPath The path of the server's Unix domain socket.
+*
+* \return Returns the connected socket.  Returns -1 on error.
+***********************************************************************************************************************/
+GF2PRIMES_API int connectToPrimeServer(char const* const socketPath);
+
+/*******************************************************************************************************************//**
+* \brief Writes a block of bytes to a socket.
+*
+* You can use this function to write every byte of a block, retrying after partial writes and interrupted calls.
+*
+* \param[in] fileDescriptor The socket to write to.
+*
+* \param[in] bytes          The bytes to write.
+*
+* \param[in] size           The number of bytes to write.
+*
+* \return Returns 0 on success.  Returns -1 if the socket was closed or could not be written.
+***********************************************************************************************************************/
+GF2PRIMES_API int sendQueryBytes(int const fileDescriptor, void const* const bytes, size_t const size);
+
+/*******************************************************************************************************************//**
+* \brief Reads a block of bytes from a socket.
+*
+* You can use this function to read exactly the requested number of bytes, retrying after partial reads and
+* interrupted calls.
+*
+* \param[in]  fileDescriptor The socket to read from.
+*
+* \param[out] bytes          The buffer receiving the bytes.
+*
+* \param[in]  size           The number of bytes to read.
+*
+* \return Returns 0 on success.  Returns -1 if the socket was closed or could not be read.
+***********************************************************************************************************************/
+GF2PRIMES_API int receiveQueryBytes(int const fileDescriptor, void* const bytes, size_t const size);
+
+#endif
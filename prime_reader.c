@@ -0,0 +1,254 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Reader for prime lists written by list_primes_gf2.
+*
+* This file implements the library used to decode the streams written by list_primes_gf2.
+***********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <unistd.h>
+#include <errno.h>
+
+#include "prime_format.h"
+#include "prime_reader.h"
+
+
+#define MINIMUM_BUFFER_SIZE (4096)
+
+
+struct PrimeReader {
+    int            fileDescriptor;
+    PrimeFormat    format;
+    uint64_t       previousPrime;
+    unsigned char* buffer;
+    size_t         bufferSize;
+    size_t         position;
+    size_t         end;
+    int            endOfStream;
+    int            failed;
+};
+
+
+static int fillBuffer(PrimeReader* const primeReader) {
+    /* Any partial value is moved to the start of the buffer before reading more.  The buffer is refilled until it
+     * holds a whole value of any format or the stream ends. */
+
+    memmove(primeReader->buffer, primeReader->buffer + primeReader->position, primeReader->end - primeReader->position);
+    primeReader->end      -= primeReader->position;
+    primeReader->position  = 0;
+
+    while (primeReader->end < PRIME_FORMAT_MAXIMUM_SIZE && !primeReader->endOfStream) {
+        ssize_t bytesRead = read(
+            primeReader->fileDescriptor,
+            primeReader->buffer + primeReader->end,
+            primeReader->bufferSize - primeReader->end
+        );
+
+        if (bytesRead > 0) {
+            primeReader->end += bytesRead;
+        } else if (bytesRead == 0) {
+            primeReader->endOfStream = 1;
+        } else if (errno != EINTR) {
+            fprintf(stderr, "*** Error: Could not read the prime list: %s.\n", strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static unsigned char const* decodeHex(
+        unsigned char const* cursor,
+        unsigned char const* end,
+        int const            endOfStream,
+        uint64_t* const      value
+    ) {
+    unsigned char const* first  = cursor;
+    uint64_t             result = 0;
+
+    while (cursor != end && *cursor != '\n' && cursor - first < 16) {
+        unsigned char c = *cursor;
+
+        if (c >= '0' && c <= '9') {
+            result = (result << 4) | (c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            result = (result << 4) | (c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            result = (result << 4) | (c - 'A' + 10);
+        } else {
+            return NULL;
+        }
+
+        ++cursor;
+    }
+
+    /* A missing newline is accepted after the last prime of the stream. */
+
+    if (cursor == first || (cursor == end ? !endOfStream : *cursor != '\n')) {
+        return NULL;
+    }
+
+    *value = result;
+
+    return cursor == end ? cursor : cursor + 1;
+}
+
+
+static unsigned char const* decodeU64le(unsigned char const* cursor, unsigned char const* end, uint64_t* const value) {
+    uint64_t result = 0;
+    unsigned i;
+
+    if (end - cursor < 8) {
+        return NULL;
+    }
+
+    for (i=0 ; i<8 ; ++i) {
+        result |= (uint64_t) cursor[i] << (8 * i);
+    }
+
+    *value = result;
+
+    return cursor + 8;
+}
+
+
+static unsigned char const* decodeVarint(unsigned char const* cursor, unsigned char const* end, uint64_t* const value) {
+    uint64_t result = 0;
+    unsigned shift  = 0;
+
+    do {
+        if (cursor == end || shift > 63) {
+            return NULL;
+        }
+
+        result |= (uint64_t) (*cursor & 0x7F) << shift;
+        shift  += 7;
+    } while (*cursor++ & 0x80);
+
+    *value = result;
+
+    return cursor;
+}
+
+
+int primeFormatFromName(char const* const name, PrimeFormat* const format) {
+    int result = 0;
+
+    if (strcmp(name, "hex") == 0) {
+        *format = PRIME_FORMAT_HEX;
+    } else if (strcmp(name, "u64le") == 0) {
+        *format = PRIME_FORMAT_U64LE;
+    } else if (strcmp(name, "delta-varint") == 0) {
+        *format = PRIME_FORMAT_DELTA_VARINT;
+    } else {
+        result = -1;
+    }
+
+    return result;
+}
+
+
+PrimeReader* createPrimeReader(int const fileDescriptor, PrimeFormat const format, size_t const bufferSizeInBytes) {
+    PrimeReader* primeReader = malloc(sizeof(PrimeReader));
+
+    assert(primeReader != NULL);
+    assert(bufferSizeInBytes >= MINIMUM_BUFFER_SIZE);
+
+    primeReader->fileDescriptor = fileDescriptor;
+    primeReader->format         = format;
+    primeReader->previousPrime  = 0;
+    primeReader->buffer         = malloc(bufferSizeInBytes);
+    primeReader->bufferSize     = bufferSizeInBytes;
+    primeReader->position       = 0;
+    primeReader->end            = 0;
+    primeReader->endOfStream    = 0;
+    primeReader->failed         = 0;
+    assert(primeReader->buffer != NULL);
+
+    return primeReader;
+}
+
+
+long readPrimes(PrimeReader* const primeReader, uint64_t* const primes, unsigned long const maximumPrimes) {
+    unsigned long numberPrimes = 0;
+
+    /* An error is reported once the primes decoded before it have been returned. */
+
+    while (numberPrimes < maximumPrimes && !primeReader->failed) {
+        unsigned char const* cursor;
+        unsigned char const* end;
+        unsigned char const* next;
+        uint64_t             value;
+
+        if (primeReader->end - primeReader->position < PRIME_FORMAT_MAXIMUM_SIZE && !primeReader->endOfStream) {
+            if (fillBuffer(primeReader) != 0) {
+                primeReader->failed = 1;
+                break;
+            }
+        }
+
+        if (primeReader->position == primeReader->end) {
+            break;
+        }
+
+        cursor = primeReader->buffer + primeReader->position;
+        end    = primeReader->buffer + primeReader->end;
+
+        switch (primeReader->format) {
+            case PRIME_FORMAT_U64LE: {
+                next = decodeU64le(cursor, end, &value);
+                break;
+            }
+
+            case PRIME_FORMAT_DELTA_VARINT: {
+                next = decodeVarint(cursor, end, &value);
+                if (next != NULL) {
+                    value                      += primeReader->previousPrime;
+                    primeReader->previousPrime  = value;
+                }
+
+                break;
+            }
+
+            default: {
+                next = decodeHex(cursor, end, primeReader->endOfStream, &value);
+                break;
+            }
+        }
+
+        if (next == NULL) {
+            fprintf(stderr, "*** Error: The prime list is truncated or malformed.\n");
+            primeReader->failed = 1;
+            break;
+        }
+
+        primes[numberPrimes++] = value;
+        primeReader->position  = next - primeReader->buffer;
+    }
+
+    return numberPrimes == 0 && primeReader->failed ? -1 : (long) numberPrimes;
+}
+
+
+void destroyPrimeReader(PrimeReader* const primeReader) {
+    free(primeReader->buffer);
+    free(primeReader);
+}
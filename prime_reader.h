@@ -0,0 +1,86 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Reader for prime lists written by list_primes_gf2.
+*
+* This file defines a small library used to read the streams written by list_primes_gf2 back into integers.  The
+* library depends only on the C library, compiler.h, and prime_format.h so it can be built into other tools.
+***********************************************************************************************************************/
+
+#ifndef PRIME_READER_H
+#define PRIME_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "compiler.h"
+#include "prime_format.h"
+
+/*******************************************************************************************************************//**
+* \brief Opaque prime reader state.
+*
+* You can use this type to decode a stream of primes read from a file descriptor.  A prime reader should only be used
+* by one thread at a time.
+***********************************************************************************************************************/
+typedef struct PrimeReader PrimeReader;
+
+/*******************************************************************************************************************//**
+* \brief Creates a prime reader.
+*
+* You can use this function to start reading primes from a file descriptor.  The file descriptor is not closed when the
+* prime reader is destroyed.
+*
+* \param[in] fileDescriptor    The file descriptor to read from, such as STDIN_FILENO.
+*
+* \param[in] format            The format the primes were written in.
+*
+* \param[in] bufferSizeInBytes The size of the input buffer.  The value must be at least 4 KBytes.
+*
+* \return Returns a newly allocated prime reader.
+***********************************************************************************************************************/
+GF2PRIMES_API PrimeReader* createPrimeReader(
+    int const         fileDescriptor,
+    PrimeFormat const format,
+    size_t const      bufferSizeInBytes
+);
+
+/*******************************************************************************************************************//**
+* \brief Reads the next primes from the stream.
+*
+* You can use this function to read primes in blocks.  Fewer than maximumPrimes are only returned at the end of the
+* stream or when an error is found.  An error message is written to stderr if the stream can not be read or is not
+* valid in the reader's format.  The primes decoded before the error are returned first and the next call returns -1.
+*
+* \param[in,out] primeReader   The prime reader to read from.
+*
+* \param[out]    primes        The array receiving the primes.
+*
+* \param[in]     maximumPrimes The number of entries in the array.
+*
+* \return Returns the number of primes read.  Returns 0 at the end of the stream.  Returns -1 on error.
+***********************************************************************************************************************/
+GF2PRIMES_API long readPrimes(
+    PrimeReader* const  primeReader,
+    uint64_t* const     primes,
+    unsigned long const maximumPrimes
+);
+
+/*******************************************************************************************************************//**
+* \brief Releases a prime reader.
+*
+* \param[in] primeReader The prime reader to be released.
+***********************************************************************************************************************/
+GF2PRIMES_API void destroyPrimeReader(PrimeReader* const primeReader);
+
+#endif
@@ -0,0 +1,530 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Answers queries against a prime list over a Unix domain socket.
+*
+* This program maps a prime list once and answers the queries described in prime_query.h for any number of local
+* clients.  Each connection is served by its own thread.  The prime list is opened read-only with every pool mapped so
+* the threads query it without locking.
+***********************************************************************************************************************/
+
+#define _GNU_SOURCE /* For ppoll */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include "compiler.h"
+#include "gf2.h"
+#include "prime_list.h"
+#include "prime_query.h"
+#include "cmdline.h"
+
+#include "parameters.h"
+
+
+/*******************************************************************************************************************//**
+* \brief Indicates the program version.
+*
+* You can use this define to specify the program version.
+***********************************************************************************************************************/
+#define VERSION ("1.0")
+
+/*******************************************************************************************************************//**
+* \brief Indicates the help text displayed by the --help switch.
+*
+* You can use this define to describe the switches supported by this program.
+***********************************************************************************************************************/
+#define HELP_TEXT \
+    "Usage: prime_server_gf2 [switches]\n" \
+    "\n" \
+    "Switches:\n" \
+    "    --prefix <prefix>          Prefix used to name the container file.\n" \
+    "    --socket <path>            Path of the Unix domain socket to listen on.\n" \
+    "    --report-interval <secs>   Seconds between throughput and latency reports, 0 to only report on exit.\n" \
+    "    --help                     Display this text.\n" \
+    "\n" \
+    "The server runs until it receives SIGINT or SIGTERM."
+
+
+/*******************************************************************************************************************//**
+* \brief A client connection.
+*
+* You can use this structure to track a connection while its thread is running.
+***********************************************************************************************************************/
+typedef struct QueryConnection {
+    struct QueryServer*     server;
+    int                     fileDescriptor;
+    struct QueryConnection* previous;
+    struct QueryConnection* next;
+} QueryConnection;
+
+/*******************************************************************************************************************//**
+* \brief State shared by the connection threads.
+*
+* You can use this structure to reach the prime list and to update the server's counters.  The lock protects the list
+* of connections and the counters.
+***********************************************************************************************************************/
+typedef struct QueryServer {
+    PrimeList*       primeList;
+    Gf2Polynomial    maximumPrime;
+    QueryConnection* connections;
+    unsigned long    numberConnections;
+    QueryStatistics  statistics;
+    QueryStatistics  intervalStatistics;
+    pthread_mutex_t  lock;
+    pthread_cond_t   connectionClosed;
+} QueryServer;
+
+
+/*******************************************************************************************************************//**
+* \brief Flag set by the signal handler when the server should stop.
+***********************************************************************************************************************/
+static volatile sig_atomic_t stopRequested = 0;
+
+
+static void requestStop(int signalNumber) {
+    (void) signalNumber;
+    stopRequested = 1;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Thread serving a single connection.
+*
+* You can use this function to answer the requests sent over a connection until the client disconnects.  Every complete
+* request received by a read is answered and the responses are sent with a single write, so pipelined requests are
+* answered in batches.  A partial request left at the end of a read is kept for the next read.
+*
+* \param[in] argument Pointer to the connection's \ref QueryConnection instance.
+*
+* \return Returns NULL.
+***********************************************************************************************************************/
+static void* connectionThread(void* argument) {
+    QueryConnection*    connection    = (QueryConnection*) argument;
+    QueryServer*        server        = connection->server;
+    size_t              bufferSize    = QUERY_BATCH_SIZE * sizeof(PrimeQueryRequest);
+    PrimeQueryRequest*  requests      = malloc(bufferSize);
+    PrimeQueryResponse* responses     = malloc(QUERY_BATCH_SIZE * sizeof(PrimeQueryResponse));
+    size_t              bytesReceived = 0;
+    int                 done          = 0;
+
+    assert(requests != NULL && responses != NULL);
+
+    while (!done) {
+        ssize_t bytesRead = read(
+            connection->fileDescriptor,
+            (char*) requests + bytesReceived,
+            bufferSize - bytesReceived
+        );
+
+        if (bytesRead > 0) {
+            unsigned long long startTime;
+            unsigned long      numberRequests;
+
+            startTime       = monotonicNanoseconds();
+            bytesReceived  += bytesRead;
+            numberRequests  = bytesReceived / sizeof(PrimeQueryRequest);
+
+            answerPrimeQueries(server->primeList, requests, responses, numberRequests);
+
+            if (numberRequests > 0) {
+                if (sendQueryBytes(connection->fileDescriptor, responses, numberRequests * sizeof(PrimeQueryResponse))
+                    != 0) {
+                    done = 1;
+                } else {
+                    unsigned long long latency = monotonicNanoseconds() - startTime;
+
+                    bytesReceived -= numberRequests * sizeof(PrimeQueryRequest);
+                    memmove(requests, requests + numberRequests, bytesReceived);
+
+                    pthread_mutex_lock(&server->lock);
+                    recordQueryLatency(&server->statistics, numberRequests, latency);
+                    recordQueryLatency(&server->intervalStatistics, numberRequests, latency);
+                    pthread_mutex_unlock(&server->lock);
+                }
+            }
+        } else if (bytesRead == 0 || errno != EINTR) {
+            done = 1;
+        }
+    }
+
+    close(connection->fileDescriptor);
+    free(requests);
+    free(responses);
+
+    pthread_mutex_lock(&server->lock);
+
+    if (connection->previous != NULL) {
+        connection->previous->next = connection->next;
+    } else {
+        server->connections = connection->next;
+    }
+
+    if (connection->next != NULL) {
+        connection->next->previous = connection->previous;
+    }
+
+    --server->numberConnections;
+    pthread_cond_signal(&server->connectionClosed);
+    pthread_mutex_unlock(&server->lock);
+
+    free(connection);
+
+    return NULL;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Starts serving a newly accepted connection.
+*
+* \param[in] server         The server accepting the connection.
+*
+* \param[in] fileDescriptor The accepted socket.
+*
+* \return Returns 0 on success.  Returns -1 if the connection thread could not be started.
+***********************************************************************************************************************/
+static int startConnection(QueryServer* const server, int const fileDescriptor) {
+    QueryConnection* connection = malloc(sizeof(QueryConnection));
+    pthread_attr_t   attributes;
+    pthread_t        thread;
+    int              status;
+
+    assert(connection != NULL);
+
+    connection->server         = server;
+    connection->fileDescriptor = fileDescriptor;
+    connection->previous       = NULL;
+
+    pthread_mutex_lock(&server->lock);
+    connection->next = server->connections;
+    if (server->connections != NULL) {
+        server->connections->previous = connection;
+    }
+
+    server->connections = connection;
+    ++server->numberConnections;
+
+    /* The thread inherits the main thread's signal mask, which blocks SIGINT and SIGTERM. */
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    status = pthread_create(&thread, &attributes, &connectionThread, connection);
+    pthread_attr_destroy(&attributes);
+
+    if (status != 0) {
+        server->connections = connection->next;
+        if (connection->next != NULL) {
+            connection->next->previous = NULL;
+        }
+
+        --server->numberConnections;
+    }
+
+    pthread_mutex_unlock(&server->lock);
+
+    if (status != 0) {
+        fprintf(stderr, "*** Error: Could not start a connection thread: %s.\n", strerror(status));
+        close(fileDescriptor);
+        free(connection);
+    }
+
+    return status == 0 ? 0 : -1;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Creates the listening socket.
+*
+* You can use this function to bind the server's socket.  A socket left behind by a server that is no longer running
+* is replaced.  An error message is written to stderr if the socket can not be created.
+*
+* \param[in] socketPath The path of the socket.
+*
+* \return Returns the listening socket.  Returns -1 on error.
+***********************************************************************************************************************/
+static int listenOnSocket(char const* const socketPath) {
+    struct sockaddr_un address;
+    int                fileDescriptor;
+    int                status;
+
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "*** Error: The socket path \"%s\" is too long.\n", socketPath);
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath);
+
+    fileDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fileDescriptor < 0) {
+        fprintf(stderr, "*** Error: Could not create a socket: %s.\n", strerror(errno));
+        return -1;
+    }
+
+    status = bind(fileDescriptor, (struct sockaddr const*) &address, sizeof(address));
+    if (status != 0 && errno == EADDRINUSE) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        /* Only a socket nobody is listening on is removed. */
+
+        if (probe >= 0 && connect(probe, (struct sockaddr const*) &address, sizeof(address)) != 0
+            && errno == ECONNREFUSED) {
+            unlink(socketPath);
+            status = bind(fileDescriptor, (struct sockaddr const*) &address, sizeof(address));
+        } else {
+            errno = EADDRINUSE;
+        }
+
+        if (probe >= 0) {
+            close(probe);
+        }
+    }
+
+    if (status != 0 || listen(fileDescriptor, SOMAXCONN) != 0) {
+        fprintf(stderr, "*** Error: Could not listen on \"%s\": %s.\n", socketPath, strerror(errno));
+        close(fileDescriptor);
+
+        return -1;
+    }
+
+    return fileDescriptor;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Accepts connections until the server is asked to stop.
+*
+* \param[in] server           The server to run.
+*
+* \param[in] listener         The listening socket.
+*
+* \param[in] reportInterval   The number of seconds between reports, 0 to disable periodic reports.
+*
+* \param[in] originalMask     The signal mask to use while waiting for connections.
+***********************************************************************************************************************/
+static void acceptConnections(
+        QueryServer* const     server,
+        int const              listener,
+        long const             reportInterval,
+        sigset_t const* const  originalMask
+    ) {
+    unsigned long long intervalStart = monotonicNanoseconds();
+    unsigned long long intervalEnd   = intervalStart + 1000000000ULL * reportInterval;
+
+    while (!stopRequested) {
+        struct pollfd   pollEntry;
+        struct timespec timeout;
+        int             status;
+
+        pollEntry.fd     = listener;
+        pollEntry.events = POLLIN;
+
+        if (reportInterval > 0) {
+            unsigned long long now       = monotonicNanoseconds();
+            unsigned long long remaining = now < intervalEnd ? intervalEnd - now : 0;
+
+            timeout.tv_sec  = remaining / 1000000000ULL;
+            timeout.tv_nsec = remaining % 1000000000ULL;
+        }
+
+        /* SIGINT and SIGTERM are only unblocked while waiting so a stop request always interrupts the wait. */
+
+        status = ppoll(&pollEntry, 1, reportInterval > 0 ? &timeout : NULL, originalMask);
+
+        if (status > 0) {
+            int fileDescriptor = accept(listener, NULL, NULL);
+
+            if (fileDescriptor >= 0) {
+                startConnection(server, fileDescriptor);
+            } else if (errno != EINTR && errno != ECONNABORTED) {
+                fprintf(stderr, "*** Error: Could not accept a connection: %s.\n", strerror(errno));
+            }
+        } else if (status < 0 && errno != EINTR) {
+            fprintf(stderr, "*** Error: Could not wait for connections: %s.\n", strerror(errno));
+            stopRequested = 1;
+        }
+
+        if (reportInterval > 0 && monotonicNanoseconds() >= intervalEnd) {
+            QueryStatistics    statistics;
+            unsigned long      numberConnections;
+            unsigned long long now = monotonicNanoseconds();
+
+            pthread_mutex_lock(&server->lock);
+            statistics        = server->intervalStatistics;
+            numberConnections = server->numberConnections;
+            initializeQueryStatistics(&server->intervalStatistics);
+            pthread_mutex_unlock(&server->lock);
+
+            printf("%lu connections.\n", numberConnections);
+            reportQueryStatistics(stdout, "Interval", &statistics, (now - intervalStart) / 1.0E9);
+
+            intervalStart = now;
+            intervalEnd   = now + 1000000000ULL * reportInterval;
+        }
+    }
+}
+
+
+int main(int argumentCount, char** argumentValues) {
+    PrimeListConfiguration configuration;
+    QueryServer            server;
+    struct sigaction       action;
+    sigset_t               stopSignals;
+    sigset_t               originalMask;
+    char*                  prefixSwitch;
+    char*                  socketSwitch;
+    long*                  reportIntervalSwitch;
+    char const*            socketPath     = QUERY_SOCKET_PATH;
+    long                   reportInterval = QUERY_REPORT_INTERVAL_IN_SECONDS;
+    unsigned long long     startTime;
+    unsigned long long     numberPrimes;
+    QueryConnection*       connection;
+    int                    listener;
+    long                   exitStatus;
+
+    CMDLINE_DEFINITION_START(switches)
+        CMDLINE_STRING("--prefix", prefixSwitch)
+        CMDLINE_STRING("--socket", socketSwitch)
+        CMDLINE_LONG("--report-interval", reportIntervalSwitch)
+        CMDLINE_HELP("--help", HELP_TEXT)
+    CMDLINE_DEFINITION_END
+
+    exitStatus = cmdLineParse(&argumentCount, argumentValues, switches);
+    if (exitStatus != 0) {
+        cmdLineReportError(exitStatus, argumentValues, switches);
+        cmdLineDeallocate(switches);
+
+        return cmdLineExitCode(exitStatus) == CMDLINE_HELP_REQUESTED ? 0 : 1;
+    }
+
+    if (argumentCount > 1) {
+        fprintf(stderr, "*** Error: Unexpected argument \"%s\".\n", argumentValues[1]);
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    if (socketSwitch != NULL) {
+        socketPath = socketSwitch;
+    }
+
+    if (reportIntervalSwitch != NULL) {
+        if (*reportIntervalSwitch < 0) {
+            fprintf(stderr, "*** Error: The report interval can not be negative.\n");
+            cmdLineDeallocate(switches);
+
+            return 1;
+        }
+
+        reportInterval = *reportIntervalSwitch;
+    }
+
+    /* Every pool is mapped up front so the connection threads can share the handle without locking. */
+
+    exitStatus = configurePrimeList(&configuration, NULL, NULL, NULL, prefixSwitch, "mapped", NULL);
+    if (exitStatus != 0) {
+        cmdLineDeallocate(switches);
+        return 1;
+    }
+
+    server.primeList = createPrimeList(&configuration, PRIME_FILE_OPEN_FOR_READING);
+    if (server.primeList == NULL) {
+        cmdLineDeallocate(switches);
+        return 1;
+    }
+
+    /* createPrimeList built the pool ranks for this read-only handle so rank queries need no locking.  The count is
+     * only reported in the startup banner. */
+
+    server.maximumPrime      = primeListMaximumPrime(server.primeList);
+    server.connections       = NULL;
+    server.numberConnections = 0;
+    numberPrimes             = countPrimesUpTo(server.primeList, server.maximumPrime);
+
+    initializeQueryStatistics(&server.statistics);
+    initializeQueryStatistics(&server.intervalStatistics);
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.connectionClosed, NULL);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = &requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &originalMask);
+
+    listener = listenOnSocket(socketPath);
+    if (listener < 0) {
+        destroyPrimeList(server.primeList);
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    printf(
+        "Serving %llu primes up to %" PRIx64 " on %s, version %s.\n",
+        numberPrimes,
+        server.maximumPrime,
+        socketPath,
+        VERSION
+    );
+    fflush(stdout);
+
+    startTime = monotonicNanoseconds();
+    acceptConnections(&server, listener, reportInterval, &originalMask);
+
+    close(listener);
+    unlink(socketPath);
+
+    /* Open connections are shut down so their threads see the end of the stream and exit. */
+
+    pthread_mutex_lock(&server.lock);
+
+    for (connection=server.connections ; connection!=NULL ; connection=connection->next) {
+        shutdown(connection->fileDescriptor, SHUT_RDWR);
+    }
+
+    while (server.numberConnections > 0) {
+        pthread_cond_wait(&server.connectionClosed, &server.lock);
+    }
+
+    pthread_mutex_unlock(&server.lock);
+
+    reportQueryStatistics(stdout, "Total", &server.statistics, (monotonicNanoseconds() - startTime) / 1.0E9);
+
+    pthread_cond_destroy(&server.connectionClosed);
+    pthread_mutex_destroy(&server.lock);
+    destroyPrimeList(server.primeList);
+    cmdLineDeallocate(switches);
+
+    return 0;
+}
@@ -15,7 +15,8 @@
 * \brief Locates prime polynomials in a GF(2) field.
 *
 * This program locates prime polynomials in a GF(2) field.  For performance reasons, the program is designed to operate
-* across multiple concurrent threads.
+* across multiple concurrent threads.  Lists that fit in the memory budget are sieved entirely in memory and written to
+* the container once.  Larger lists are sieved through the pool cache or memory mapped pools.
 ***********************************************************************************************************************/
 
 #include <stdio.h>
@@ -35,7 +36,13 @@
 
 #include "compiler.h"
 #include "gf2.h"
+#include "popcount.h"
 #include "prime_list.h"
+#include "sieving_primes.h"
+#include "bucket_sieve.h"
+#include "presieve.h"
+#include "checkpoint.h"
+#include "cmdline.h"
 
 #include "parameters.h"
 
@@ -47,20 +54,106 @@
 ***********************************************************************************************************************/
 #define VERSION ("1.0")
 
+/*******************************************************************************************************************//**
+* \brief Indicates the help text displayed by the --help switch.
+*
+* You can use this define to describe the switches supported by this program.
+***********************************************************************************************************************/
+#define HELP_TEXT \
+    "Usage: sieve_of_eratosthenes_gf2 [switches]\n" \
+    "\n" \
+    "Switches:\n" \
+    "    --maximum-prime <value>  Largest value to sieve, in decimal or 0x prefixed hexadecimal.\n" \
+    "    --pool-size <bytes>      Size of each pool.  Must be a multiple of 8 from 65536 to 1073741824.\n" \
+    "    --puddle-size <bits>     Width of the words used to access a pool, 32 or 64.\n" \
+    "    --cache-size <bytes>     Memory budget for the pools kept resident, including the worker buffers.\n" \
+    "    --storage <storage>      Hold the pools in memory, in the pool cache, or memory mapped using memory,\n" \
+    "                             pooled, or mapped.  The default, auto, uses memory when the list fits in the\n" \
+    "                             memory budget and mapped otherwise.  Progress is not checkpointed when the\n" \
+    "                             pools are held in memory so --resume restarts such a run from its start.\n" \
+    "    --memory-map             Same as --storage mapped.\n" \
+    "    --prefix <prefix>        Prefix used to name the container and checkpoint files.\n" \
+    "    --threads <count>        Number of sieve threads, 0 for one per processor.  A resumed run uses the\n" \
+    "                             number of threads recorded in the checkpoint.\n" \
+    "    --resume                 Continue the run recorded in the checkpoint file.\n" \
+    "    --help                   Display this text."
+
+
+/*******************************************************************************************************************//**
+* \brief State tracked for each segmented sieve worker thread.
+*
+* You can use this structure to describe the range of pools owned by a single worker thread.
+***********************************************************************************************************************/
+typedef struct SieveWorker {
+    pthread_t            thread;
+    SievingPrimes const* sievingPrimes;
+    Presieve const*      presieve;
+    unsigned long        rangeIndex;
+    unsigned long        firstPool;
+    unsigned long        endPool;
+} SieveWorker;
+
+
+Gf2Polynomial          prime;
+Gf2Polynomial          q;
+unsigned long          poolsCompleted;
+pthread_mutex_t        poolsCompletedLock = PTHREAD_MUTEX_INITIALIZER;
+int                    done;
+pthread_t              monitorThreadData;
+Checkpoint             checkpoint;
+char*                  checkpointFilename;
+int                    checkpointProgress;
+PrimeListConfiguration configuration;
+PrimeList*             primeList;
+
+
+/*******************************************************************************************************************//**
+* \brief Starts the checkpoint for a new run.
+*
+* You can use this function to initialize the global checkpoint with the parameters of this run.
+*
+* \param[in] numberRanges The number of worker ranges to track.  Use 0 for the prime ordered sieve.
+***********************************************************************************************************************/
+static void startCheckpoint(unsigned long const numberRanges) {
+    initializeCheckpoint(&checkpoint, numberRanges);
 
-Gf2Polynomial prime;
-Gf2Polynomial q;
-int           done;
-pthread_t     monitorThreadData;
+    checkpoint.maximumPrime    = configuration.maximumPrime;
+    checkpoint.poolSizeInBytes = configuration.poolSizeInBytes;
+    checkpoint.puddleSize      = configuration.puddleSize;
+    checkpoint.segmented       = SEGMENTED_SIEVE;
+}
+
+
+/*******************************************************************************************************************//**
+* \brief Determines if the global checkpoint can be resumed by this run.
+*
+* \param[in] sievingPrimes The table of sieving primes.
+*
+* \return Returns non-zero if the checkpoint was written by a run with the same parameters.
+***********************************************************************************************************************/
+static int checkpointMatches(SievingPrimes const* const sievingPrimes) {
+    return (
+           checkpoint.maximumPrime     == configuration.maximumPrime
+        && checkpoint.poolSizeInBytes  == configuration.poolSizeInBytes
+        && checkpoint.puddleSize       == configuration.puddleSize
+        && checkpoint.segmented        == SEGMENTED_SIEVE
+        && checkpoint.nextSievingPrime <= sievingPrimes->numberPrimes
+        && (checkpoint.segmented != 0) == (checkpoint.numberRanges != 0)
+    );
+}
 
 
 void* monitorThread(void* dummy) {
     time_t startTime = time(NULL);
 
     do {
-        unsigned pulse = 60;
-        time_t   elapsedTime;
-        double   fraction;
+        unsigned      pulse = 60;
+        time_t        elapsedTime;
+        double        fraction;
+
+        #if (SEGMENTED_SIEVE)
+            unsigned long completed;
+        #endif
 
         do {
             sleep(1);
@@ -68,48 +161,438 @@ void* monitorThread(void* dummy) {
         } while (!done && pulse > 0);
 
         elapsedTime = time(NULL) - startTime;
-        fraction    = (1.0 * (q - prime)) / (MAXIMUM_PRIME - prime);
 
-        printf("%16d\t%" PRIx64 "\t%" PRIx64 "\t%lf\n", elapsedTime, prime, q, fraction);
+        #if (SEGMENTED_SIEVE)
+
+            pthread_mutex_lock(&poolsCompletedLock);
+            completed = poolsCompleted;
+            pthread_mutex_unlock(&poolsCompletedLock);
+
+            fraction = (1.0 * completed) / primeListNumberPools(primeList);
+
+            printf(
+                "%16ld\t%lu\t%lu\t%lf\n",
+                (long) elapsedTime,
+                completed,
+                primeListNumberPools(primeList),
+                fraction
+            );
+
+        #else
+
+            fraction = (1.0 * (q - prime)) / (primeListMaximumPrime(primeList) - prime);
+
+            printf("%16ld\t%" PRIx64 "\t%" PRIx64 "\t%lf\n", (long) elapsedTime, prime, q, fraction);
+
+        #endif
     } while (!done);
 
     pthread_exit(NULL);
 }
 
 
+#if (SEGMENTED_SIEVE)
+
+    /***************************************************************************************************************//**
+    * \brief Records that a pool has been sieved and written back.
+    *
+    * \param[in] worker    The worker that sieved the pool.
+    *
+    * \param[in] poolIndex The zero based index of the pool.
+    *******************************************************************************************************************/
+    static void completePool(SieveWorker const* const worker, unsigned long const poolIndex) {
+        pthread_mutex_lock(&poolsCompletedLock);
+        ++poolsCompleted;
+        checkpoint.ranges[worker->rangeIndex].nextPool = poolIndex + 1;
+
+        if (checkpointProgress) {
+            writeCheckpoint(&checkpoint, checkpointFilename);
+        }
+
+        pthread_mutex_unlock(&poolsCompletedLock);
+    }
+
+    /***************************************************************************************************************//**
+    * \brief Worker thread used by the segmented sieve.
+    *
+    * You can use this function as the entry point for a thread that sieves a contiguous range of pools.  Each pool is
+    * loaded into a private buffer and every sieving prime is applied.  The next pool is read and the previous pool is
+    * written back in the background while the current pool is sieved.  The smallest sieving primes are stamped through
+    * the shared pre-sieve and sieving primes that land at most one mark per segment are applied through a bucket sieve.
+    * The checkpoint is updated once each pool has been written back.
+    *
+    * \param[in] argument Pointer to the \ref SieveWorker instance describing the work.
+    *
+    * \return Returns NULL.
+    *******************************************************************************************************************/
+    static void* sieveWorkerThread(void* argument) {
+        SieveWorker const*   worker          = (SieveWorker const*) argument;
+        SievingPrimes const* sievingPrimes   = worker->sievingPrimes;
+        PoolBuffer*          poolBuffer      = createPoolBuffer(primeList);
+        unsigned             segmentSizeLog2 = gf2Degree(8 * 2 * (Gf2Polynomial) SIEVE_SEGMENT_SIZE_IN_BYTES);
+        unsigned long        firstLarge      = firstBucketSievingPrime(sievingPrimes, segmentSizeLog2);
+        BucketSieve*         bucketSieve;
+        unsigned long        poolIndex;
+        Gf2Polynomial        firstValue;
+        Gf2Polynomial        lastValue;
+        Gf2Polynomial        unused;
+
+        primeListPoolBounds(primeList, worker->firstPool, &firstValue, &unused);
+        primeListPoolBounds(primeList, worker->endPool - 1, &unused, &lastValue);
+
+        bucketSieve = createBucketSieve(sievingPrimes, firstLarge, segmentSizeLog2, firstValue, lastValue);
+
+        for (poolIndex=worker->firstPool ; poolIndex < worker->endPool ; ++poolIndex) {
+            unsigned long i;
+
+            loadPoolBuffer(poolBuffer, poolIndex);
+            if (poolIndex + 1 < worker->endPool) {
+                prefetchPoolBuffer(poolBuffer, poolIndex + 1);
+            }
+
+            applyPresieve(worker->presieve, poolBuffer);
+
+            for (i=presieveNumberPrimes(worker->presieve) ; i<firstLarge ; ++i) {
+                markMultiplesInPoolBuffer(poolBuffer, sievingPrimes->primes[i]);
+            }
+
+            applyBucketSieve(bucketSieve, poolBuffer);
+
+            /* The previous pool was written back in the background while this pool was sieved. */
+
+            if (poolIndex > worker->firstPool) {
+                waitForPoolBuffer(poolBuffer);
+                completePool(worker, poolIndex - 1);
+            }
+        }
+
+        storePoolBuffer(poolBuffer);
+        completePool(worker, worker->endPool - 1);
+
+        destroyBucketSieve(bucketSieve);
+        destroyPoolBuffer(poolBuffer);
+
+        return NULL;
+    }
+
+    /***************************************************************************************************************//**
+    * \brief Applies the sieve one pool at a time.
+    *
+    * You can use this function to sieve the prime list in pool order.  The pools are divided into contiguous ranges,
+    * one per worker thread, and every sieving prime is applied to a pool while it is resident so each pool is loaded
+    * and flushed once.  When resuming, the ranges and the pools still to be sieved are taken from the checkpoint.
+    *
+    * \param[in] sievingPrimes The table of sieving primes to apply.
+    *
+    * \param[in] resume        If non-zero, the global checkpoint holds the progress of an earlier run.
+    *
+    * \param[in] numberThreads The number of worker threads to use for a new run.
+    *******************************************************************************************************************/
+    static void segmentedSieve(
+            SievingPrimes const* const sievingPrimes,
+            int const                  resume,
+            unsigned long              numberThreads
+        ) {
+        unsigned long numberPools     = primeListNumberPools(primeList);
+        unsigned      segmentSizeLog2 = gf2Degree(8 * 2 * (Gf2Polynomial) SIEVE_SEGMENT_SIZE_IN_BYTES);
+        unsigned      presieveDegree  = PRESIEVE_MAXIMUM_DEGREE;
+        Presieve*     presieve;
+        SieveWorker*  workers;
+        unsigned long i;
+
+        if (resume) {
+            numberThreads  = checkpoint.numberRanges;
+            poolsCompleted = numberPools;
+
+            for (i=0 ; i<numberThreads ; ++i) {
+                assert(checkpoint.ranges[i].endPool <= numberPools);
+                poolsCompleted -= checkpoint.ranges[i].endPool - checkpoint.ranges[i].nextPool;
+            }
+        } else {
+            unsigned long long bufferedBytes = 3 * (unsigned long long) configuration.poolSizeInBytes;
+            unsigned long      budgetThreads = configuration.cacheSizeInBytes / bufferedBytes;
+
+            /* Each worker's pool buffer holds up to three pools unless the pools are updated in place in memory. */
+
+            if (budgetThreads == 0) {
+                budgetThreads = 1;
+            }
+
+            if (primeListStorage(primeList) != PRIME_LIST_STORAGE_MEMORY && numberThreads > budgetThreads) {
+                numberThreads = budgetThreads;
+                printf("Limiting the sieve to %lu threads to stay within the memory budget.\n", numberThreads);
+            }
+
+            if (numberThreads > numberPools) {
+                numberThreads = numberPools;
+            }
+
+            startCheckpoint(numberThreads);
+            for (i=0 ; i<numberThreads ; ++i) {
+                checkpoint.ranges[i].nextPool = (numberPools * i) / numberThreads;
+                checkpoint.ranges[i].endPool  = (numberPools * (i + 1)) / numberThreads;
+            }
+        }
+
+        if (presieveDegree >= segmentSizeLog2) {
+            presieveDegree = segmentSizeLog2 - 1;
+        }
+
+        presieve = createPresieve(sievingPrimes, presieveDegree);
+        printf("Pre-sieving %lu primes.\n", presieveNumberPrimes(presieve));
+
+        printf("Sieving %lu pools across %lu threads.\n", numberPools - poolsCompleted, numberThreads);
+
+        workers = malloc(numberThreads * sizeof(SieveWorker));
+        assert(workers != NULL);
+
+        flushPrimeList(primeList);
+        writeCheckpoint(&checkpoint, checkpointFilename);
+
+        for (i=0 ; i<numberThreads ; ++i) {
+            workers[i].sievingPrimes = sievingPrimes;
+            workers[i].presieve      = presieve;
+            workers[i].rangeIndex    = i;
+            workers[i].firstPool     = checkpoint.ranges[i].nextPool;
+            workers[i].endPool       = checkpoint.ranges[i].endPool;
+
+            if (workers[i].firstPool < workers[i].endPool) {
+                int status = pthread_create(&workers[i].thread, NULL, &sieveWorkerThread, workers + i);
+                assert(status == 0);
+            }
+        }
+
+        for (i=0 ; i<numberThreads ; ++i) {
+            if (workers[i].firstPool < workers[i].endPool) {
+                pthread_join(workers[i].thread, NULL);
+            }
+        }
+
+        free(workers);
+        destroyPresieve(presieve);
+        done = 1;
+    }
+
+#else
+
+    /***************************************************************************************************************//**
+    * \brief Applies the sieve one prime at a time.
+    *
+    * You can use this function to sieve the prime list in prime order.  Each prime is applied across every pool before
+    * moving to the next prime in the table.  The resident pool is flushed and the checkpoint is updated every
+    * CHECKPOINT_INTERVAL_IN_SECONDS.  Reapplying a partially applied prime after a resume is harmless.
+    *
+    * \param[in] sievingPrimes The table of sieving primes to apply.
+    *
+    * \param[in] resume        If non-zero, the global checkpoint holds the progress of an earlier run.
+    *******************************************************************************************************************/
+    static void primeOrderedSieve(SievingPrimes const* const sievingPrimes, int const resume) {
+        time_t        lastCheckpointTime;
+        unsigned long i;
+
+        if (!resume) {
+            startCheckpoint(0);
+            flushPrimeList(primeList);
+            writeCheckpoint(&checkpoint, checkpointFilename);
+        }
+
+        lastCheckpointTime = time(NULL);
+
+        /* Marking the multiples of the larger primes touches roughly one value per page. */
+
+        advisePrimeList(primeList, PRIME_LIST_ACCESS_RANDOM);
+
+        for (i=checkpoint.nextSievingPrime ; i<sievingPrimes->numberPrimes ; ++i) {
+            Gf2MultipleIterator multiples;
+            Gf2Polynomial       product;
+
+            prime = sievingPrimes->primes[i];
+
+            gf2MultiplesStart(&multiples, prime, gf2Degree(prime), primeListMaximumPrime(primeList), 1);
+            while ((product = gf2MultiplesNext(&multiples)) != 0) {
+                markComposite(primeList, product);
+                q = multiples.multiplier;
+            }
+
+            if (checkpointProgress && time(NULL) - lastCheckpointTime >= CHECKPOINT_INTERVAL_IN_SECONDS) {
+                flushPrimeList(primeList);
+                checkpoint.nextSievingPrime = i + 1;
+                writeCheckpoint(&checkpoint, checkpointFilename);
+
+                lastCheckpointTime = time(NULL);
+            }
+        }
+
+        flushPrimeList(primeList);
+        checkpoint.nextSievingPrime = sievingPrimes->numberPrimes;
+        writeCheckpoint(&checkpoint, checkpointFilename);
+
+        done = 1;
+    }
+
+#endif
+
+
 int main(int argumentCount, char** argumentValues) {
-    void* dummyResult;
+    void*              dummyResult;
+    SievingPrimes      sievingPrimes;
+    char*              maximumPrimeSwitch;
+    long*              poolSizeSwitch;
+    long*              puddleSizeSwitch;
+    char*              prefixSwitch;
+    char*              storageSwitch;
+    int*               memoryMapSwitch;
+    long*              cacheSizeSwitch;
+    long*              threadsSwitch;
+    int*               resumeSwitch;
+    int                resume;
+    unsigned long      numberThreads = NUMBER_SIEVE_THREADS;
+    unsigned long long cacheHits;
+    unsigned long long cacheMisses;
+    long               exitStatus;
+
+    CMDLINE_DEFINITION_START(switches)
+        CMDLINE_STRING("--maximum-prime", maximumPrimeSwitch)
+        CMDLINE_LONG("--pool-size", poolSizeSwitch)
+        CMDLINE_LONG("--puddle-size", puddleSizeSwitch)
+        CMDLINE_STRING("--prefix", prefixSwitch)
+        CMDLINE_STRING("--storage", storageSwitch)
+        CMDLINE_BOOL_TRUE("--memory-map", memoryMapSwitch)
+        CMDLINE_LONG("--cache-size", cacheSizeSwitch)
+        CMDLINE_LONG("--threads", threadsSwitch)
+        CMDLINE_BOOL_TRUE("--resume", resumeSwitch)
+        CMDLINE_HELP("--help", HELP_TEXT)
+    CMDLINE_DEFINITION_END
+
+    exitStatus = cmdLineParse(&argumentCount, argumentValues, switches);
+    if (exitStatus != 0) {
+        cmdLineReportError(exitStatus, argumentValues, switches);
+        cmdLineDeallocate(switches);
+
+        return cmdLineExitCode(exitStatus) == CMDLINE_HELP_REQUESTED ? 0 : 1;
+    }
+
+    if (argumentCount > 1) {
+        fprintf(stderr, "*** Error: Unexpected argument \"%s\".\n", argumentValues[1]);
+        cmdLineDeallocate(switches);
+
+        return 1;
+    }
+
+    exitStatus = configurePrimeList(
+        &configuration,
+        maximumPrimeSwitch,
+        poolSizeSwitch,
+        puddleSizeSwitch,
+        prefixSwitch,
+        memoryMapSwitch != NULL && *memoryMapSwitch ? "mapped" : storageSwitch,
+        cacheSizeSwitch
+    );
+
+    if (exitStatus != 0) {
+        cmdLineDeallocate(switches);
+        return 1;
+    }
+
+    if (threadsSwitch != NULL) {
+        if (*threadsSwitch < 0) {
+            fprintf(stderr, "*** Error: The number of threads can not be negative.\n");
+            cmdLineDeallocate(switches);
+
+            return 1;
+        }
+
+        numberThreads = (unsigned long) *threadsSwitch;
+    }
+
+    resume = resumeSwitch != NULL && *resumeSwitch;
 
     done  = 0;
     prime = 3;
     q     = 3;
 
-    initializePrimeList(PRIME_FILE_PREFIX, PRIME_FILE_CREATE_NEW);
-    markComposite(0);
-    markComposite(1);
+    checkpointFilename = malloc(strlen(configuration.filePrefix) + 11);
+    assert(checkpointFilename != NULL);
+    sprintf(checkpointFilename, "%scheckpoint", configuration.filePrefix);
 
-    pthread_create(&monitorThreadData, NULL, &monitorThread, NULL);
+    printf("Using %s multiply.\n", gf2MultiplyImplementation());
+    printf("Using %s popcount.\n", popcountMethod());
 
-    do {
-        Gf2Polynomial product = gf2Multiply(prime, prime);;
+    initializeSievingPrimes(&sievingPrimes, configuration.maximumPrime);
+    printf("Located %lu sieving primes.\n", sievingPrimes.numberPrimes);
 
-        if (product > MAXIMUM_PRIME) {
-            done = 1;
-        } else {
-            do {
-                markComposite(product);
-                q += 2;
-                product = gf2Multiply(prime, q);
-            } while (product <= MAXIMUM_PRIME);
+    if (numberThreads == 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        numberThreads = processors > 0 ? (unsigned long) processors : 1;
+    }
+
+    if (resume) {
+        if (readCheckpoint(&checkpoint, checkpointFilename) != 0) {
+            fprintf(stderr, "Unable to read checkpoint %s.\n", checkpointFilename);
+            return 1;
         }
 
-        prime = findNextPrime(prime);
-        q = prime;
-    } while (!done && prime != 0);
+        if (!checkpointMatches(&sievingPrimes)) {
+            fprintf(stderr, "Checkpoint %s was written with different parameters.\n", checkpointFilename);
+            return 1;
+        }
+
+        printf("Resuming from %s.\n", checkpointFilename);
+        numberThreads = checkpoint.numberRanges;
+    }
+
+    configuration.numberPoolBuffers = SEGMENTED_SIEVE ? numberThreads : 0;
+    primeList = createPrimeList(&configuration, resume ? PRIME_FILE_OPEN_FOR_UPDATE : PRIME_FILE_CREATE_NEW);
+
+    if (primeList == NULL) {
+        return 1;
+    }
 
-    terminatePrimeList();
+    /* Pools held in memory only reach the container when the list is flushed at the end of the run, so the checkpoint
+     * left by the start of the run, or by an earlier run, stays in place until then. */
+
+    checkpointProgress = primeListStorage(primeList) != PRIME_LIST_STORAGE_MEMORY;
+    printf("Using %s storage.\n", primeListStorageName(primeListStorage(primeList)));
+
+    if (!checkpointProgress) {
+        printf("Progress is not checkpointed.  An interrupted run resumes from its start.\n");
+    }
+
+    if (!resume) {
+        markComposite(primeList, 0);
+        markComposite(primeList, 1);
+    }
+
+    pthread_create(&monitorThreadData, NULL, &monitorThread, NULL);
+
+    #if (SEGMENTED_SIEVE)
+
+        segmentedSieve(&sievingPrimes, resume, numberThreads);
+
+    #else
+
+        primeOrderedSieve(&sievingPrimes, resume);
+
+    #endif
+
+    flushPrimeList(primeList);
+
+    if (!checkpointProgress) {
+        writeCheckpoint(&checkpoint, checkpointFilename);
+    }
+
+    primeListCacheStatistics(primeList, &cacheHits, &cacheMisses);
+    printf("Pool cache: %llu hits, %llu misses.\n", cacheHits, cacheMisses);
+    printf("Wrote %llu bytes of pool data.\n", primeListBytesWritten(primeList));
+
+    destroyPrimeList(primeList);
+    terminateSievingPrimes(&sievingPrimes);
+    terminateCheckpoint(&checkpoint);
+    free(checkpointFilename);
 
     pthread_join(monitorThreadData, &dummyResult);
 
+    cmdLineDeallocate(switches);
+
     return 0;
 }
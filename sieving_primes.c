@@ -0,0 +1,114 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Maintains the in-memory table of sieving primes.
+*
+* This file implements functions used to locate and hold the small prime polynomials needed to sieve the prime list.
+***********************************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "compiler.h"
+#include "gf2.h"
+#include "sieving_primes.h"
+
+
+static void appendPrime(SievingPrimes* const sievingPrimes, unsigned long* const capacity, Gf2Polynomial const prime) {
+    if (sievingPrimes->numberPrimes == *capacity) {
+        *capacity = *capacity == 0 ? 1024 : 2 * *capacity;
+
+        sievingPrimes->primes = realloc(sievingPrimes->primes, *capacity * sizeof(uint32_t));
+        assert(sievingPrimes->primes != NULL);
+    }
+
+    sievingPrimes->primes[sievingPrimes->numberPrimes] = (uint32_t) prime;
+    ++sievingPrimes->numberPrimes;
+}
+
+
+void initializeSievingPrimes(SievingPrimes* const sievingPrimes, Gf2Polynomial const maximumPrime) {
+    unsigned long capacity      = 0;
+    unsigned      maximumDegree = gf2Degree(maximumPrime) / 2;
+    Gf2Polynomial limit         = ((Gf2Polynomial) 2 << maximumDegree) - 1;
+    Gf2Polynomial numberBits    = (limit + 1) / 2;
+    Gf2Polynomial numberWords   = (numberBits + 63) / 64;
+    uint64_t*     candidates;
+    Gf2Polynomial bit;
+
+    assert(maximumDegree < 32);
+
+    sievingPrimes->primes        = NULL;
+    sievingPrimes->numberPrimes  = 0;
+    sievingPrimes->maximumDegree = maximumDegree;
+
+    /* Bit i of the candidate list tracks the odd value 2i+1.  Only primes of at most half the maximum degree need to
+     * mark the list; the rest are simply collected as they are reached. */
+
+    candidates = malloc(numberWords * sizeof(uint64_t));
+    assert(candidates != NULL);
+
+    memset(candidates, 0xFF, numberWords * sizeof(uint64_t));
+    candidates[0] &= ~(uint64_t) 1;
+
+    for (bit=1 ; bit < numberBits ; ++bit) {
+        if ((candidates[bit / 64] >> (bit % 64)) & 1) {
+            Gf2Polynomial prime = 2 * bit + 1;
+
+            appendPrime(sievingPrimes, &capacity, prime);
+
+            if (2 * gf2Degree(prime) <= maximumDegree) {
+                Gf2MultipleIterator multiples;
+                Gf2Polynomial       multiple;
+
+                gf2MultiplesStart(&multiples, prime, gf2Degree(prime), limit, 1);
+                while ((multiple = gf2MultiplesNext(&multiples)) != 0) {
+                    Gf2Polynomial m = multiple >> 1;
+                    candidates[m / 64] &= ~((uint64_t) 1 << (m % 64));
+                }
+            }
+        }
+    }
+
+    free(candidates);
+}
+
+
+unsigned long firstSievingPrimeOfDegree(SievingPrimes const* const sievingPrimes, unsigned const degree) {
+    unsigned long low  = 0;
+    unsigned long high = sievingPrimes->numberPrimes;
+
+    while (low < high) {
+        unsigned long middle = low + (high - low) / 2;
+
+        if (gf2Degree(sievingPrimes->primes[middle]) < degree) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+void terminateSievingPrimes(SievingPrimes* const sievingPrimes) {
+    free(sievingPrimes->primes);
+
+    sievingPrimes->primes       = NULL;
+    sievingPrimes->numberPrimes = 0;
+}
@@ -0,0 +1,75 @@
+/*-*-c++-*-*************************************************************************************************************
+* Copyright (C) 2015 by Paul H. Smith
+*
+* This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+* License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later
+* version.
+*
+* This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with this program.  If not, see
+* <http://www.gnu.org/licenses/>.
+********************************************************************************************************************//**
+* \file
+* \brief Maintains the in-memory table of sieving primes.
+*
+* This file defines functions used to locate and hold the small prime polynomials needed to sieve the prime list.
+***********************************************************************************************************************/
+
+#ifndef SIEVING_PRIMES_H
+#define SIEVING_PRIMES_H
+
+#include <stdint.h>
+
+#include "gf2.h"
+
+/*******************************************************************************************************************//**
+* \brief Table of sieving primes.
+*
+* You can use this structure to hold every odd prime polynomial whose degree is at most half the degree of the maximum
+* prime.  Every composite up to the maximum prime has at least one factor in this table.  Sieving primes have degree of
+* at most 31 so each entry is held in 32 bits.  Entries are stored in increasing order.
+***********************************************************************************************************************/
+typedef struct SievingPrimes {
+    uint32_t*     primes;
+    unsigned long numberPrimes;
+    unsigned      maximumDegree;
+} SievingPrimes;
+
+/*******************************************************************************************************************//**
+* \brief Locates the sieving primes.
+*
+* You can use this function to build the table of sieving primes.  The primes are located with a small private sieve
+* held in memory and are appended to the table as they are found, so the prime list itself is never consulted.
+*
+* \param[out] sievingPrimes The table to populate.
+*
+* \param[in]  maximumPrime  The largest value that will be sieved.
+***********************************************************************************************************************/
+void initializeSievingPrimes(SievingPrimes* const sievingPrimes, Gf2Polynomial const maximumPrime);
+
+/*******************************************************************************************************************//**
+* \brief Locates the first sieving prime of at least a given degree.
+*
+* You can use this function to split the table of sieving primes by degree.
+*
+* \param[in] sievingPrimes The table of sieving primes.
+*
+* \param[in] degree        The degree to search for.
+*
+* \return Returns the index of the first sieving prime whose degree is at least degree.  The number of primes in the
+*         table is returned if there is no such prime.
+***********************************************************************************************************************/
+unsigned long firstSievingPrimeOfDegree(SievingPrimes const* const sievingPrimes, unsigned const degree);
+
+/*******************************************************************************************************************//**
+* \brief Releases the table of sieving primes.
+*
+* You can use this function to release memory held by a table of sieving primes.
+*
+* \param[in,out] sievingPrimes The table to release.
+***********************************************************************************************************************/
+void terminateSievingPrimes(SievingPrimes* const sievingPrimes);
+
+#endif